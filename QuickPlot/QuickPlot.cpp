@@ -9,10 +9,26 @@
 
 #include <qapplication.h>
 #include <qwt_plot.h>
-#include <qwt_matrix_raster_data.h>
+#include <qwt_raster_data.h>
+#include <qnumeric.h>
 #include <qwt_plot_spectrogram.h>
 #include <qwt_color_map.h>
 #include <qwt_scale_widget.h>
+#include <qwt_plot_zoomer.h>
+#include <qwt_plot_panner.h>
+#include <qimage.h>
+#include <qrunnable.h>
+#include <qthreadpool.h>
+#include <qsemaphore.h>
+#include <qmutex.h>
+#include <qthread.h>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <math.h>
+#include <vector>
+
+#include "QuickPlot.h"
 
 /* setting color map */
 class ColorMap: public QwtLinearColorMap
@@ -33,33 +49,123 @@ public:
     }
 };
 
-/* plot 2D float array */
-void QuickPlot(int nx, int ny, float **data)
+/* Raster data referencing contiguous 2D float array (x fastest varying)
+ * without copying it (values are looked up as nearest grid cell).
+ * Fields larger than max_dim get a pyramid of 2x2 mean downsampled levels
+ * (built once), rendering uses the coarsest level still finer than a screen pixel.
+ */
+class FloatRasterData: public QwtRasterData
+{
+public:
+    FloatRasterData(int nx, int ny, const float *data, int max_dim):
+        cur(0)
+    {
+        lnx.push_back(nx);
+        lny.push_back(ny);
+        ldata.push_back(data);
+        while (qMax(lnx.back(), lny.back()) > max_dim)
+            add_level();
+    }
+
+    int levels() const { return int(ldata.size()); }
+
+    /* selects level matching size of screen pixels of area to be rendered */
+    virtual void initRaster(const QRectF &area, const QSize &raster)
+    {
+        const QwtInterval xi = interval(Qt::XAxis);
+        const QwtInterval yi = interval(Qt::YAxis);
+        double px = area.width() / qMax(raster.width(), 1) / (xi.width() / lnx[0]); /* cells per pixel */
+        double py = area.height() / qMax(raster.height(), 1) / (yi.width() / lny[0]);
+        double cells = qMin(px, py);
+        cur = 0;
+        while (cur+1 < levels() && double(1 << (cur+1)) <= cells)
+            cur++;
+    }
+
+    virtual double value(double x, double y) const
+    {
+        const QwtInterval xi = interval(Qt::XAxis);
+        const QwtInterval yi = interval(Qt::YAxis);
+        const int nx = lnx[cur], ny = lny[cur];
+        int i = int((x - xi.minValue()) / xi.width() * lnx[0]) >> cur;
+        int j = int((y - yi.minValue()) / yi.width() * lny[0]) >> cur;
+        if (i < 0 || j < 0 || i >= nx || j >= ny)
+            return qQNaN();
+        return ldata[cur][long(j)*nx+i];
+    }
+
+private:
+    std::vector<int> lnx, lny;
+    std::vector<const float *> ldata;	/* level 0 is caller data */
+    std::vector< std::vector<float> > pyramid;	/* storage of levels > 0 */
+    int cur;	/* level used for rendering */
+
+    /* appends level of half resolution (mean of valid values of 2x2 cells) */
+    void add_level()
+    {
+        const int nx = lnx.back(), ny = lny.back();
+        const float *src = ldata.back();
+        const int mx = (nx+1)/2, my = (ny+1)/2;
+        pyramid.push_back(std::vector<float>(long(mx)*my));
+        float *dst = &pyramid.back()[0];
+        for (int j = 0; j < my; j++) {
+            for (int i = 0; i < mx; i++) {
+                float sum = 0;
+                int n = 0;
+                for (int jj = 2*j; jj < qMin(2*j+2, ny); jj++) {
+                    for (int ii = 2*i; ii < qMin(2*i+2, nx); ii++) {
+                        float v = src[long(jj)*nx+ii];
+                        if (v == v) { sum += v; n++; }
+                    }
+                }
+                dst[long(j)*mx+i] = n ? sum/n : float(qQNaN());
+            }
+        }
+        lnx.push_back(mx);
+        lny.push_back(my);
+        ldata.push_back(dst);
+    }
+};
+
+/* returns minimum and maximum of array in one linear pass (NaN values are ignored) */
+static void value_range(long n, const float *data, float *min_val, float *max_val)
+{
+	float lo = HUGE_VALF, hi = -HUGE_VALF;
+	for (long i = 0; i < n; i++) {
+		float v = data[i];
+		lo = (v < lo) ? v : lo; /* false for NaN */
+		hi = (v > hi) ? v : hi;
+	}
+	if (lo > hi) lo = hi = 0; /* no valid value */
+	*min_val = lo;
+	*max_val = hi;
+}
+
+/* plot contiguous 2D float array (x fastest varying, i.e. data[j*nx+i]) */
+void QuickPlot_xy(int nx, int ny, const float *data)
+{
+	float min_val, max_val;
+
+	/* get min and max values of data */
+	value_range(long(nx)*ny, data, &min_val, &max_val);
+
+	QuickPlot_xy(nx, ny, data, min_val, max_val);
+}
+
+/* plot contiguous 2D float array with colour scale range min_val..max_val */
+void QuickPlot_xy(int nx, int ny, const float *data, float min_val, float max_val)
 {
 	float max_plot_dim = 800.0;
 	float xfac = 1.0;
         float yfac = 1.0;
-	float min_val, max_val;
 
 	/* initialize the window system and construct an application object */
 	char *argv[] = {(char*)&"Quick Plot", NULL};
 	int argc = 1;
 	QApplication app(argc, argv);
 
-	/* transform data into QVector */	
-	QVector<double> zVector(nx*ny);
-	for(long i = 0; i < nx; i++)
-		for(long j = 0; j < ny; j++)
-			zVector[j+i*ny] = double(data[i][j]);
-
-	/* transform data into matrix format */	
-	QwtMatrixRasterData *matrix = new QwtMatrixRasterData();
-	matrix->setValueMatrix(zVector, nx);
-
-	/* get min and max values of data */
-	qStableSort(zVector.begin(),zVector.end());
-	min_val = zVector.first();
- 	max_val = zVector.last();
+	/* reference data as raster (data has to stay valid until window is closed) */
+	FloatRasterData *matrix = new FloatRasterData(nx, ny, data, int(max_plot_dim));
 
 	/* set intervals of matrix */
 	matrix->setInterval(
@@ -101,6 +207,13 @@ void QuickPlot(int nx, int ny, float **data)
 	spectrogram->setData(matrix);
 	spectrogram->attach(plot);
 
+	/* zoom with left mouse button (right button zooms out), pan with middle button
+	 * (large fields are drawn from the pyramid level matching the zoom) */
+	QwtPlotZoomer *zoomer = new QwtPlotZoomer(plot->canvas());
+	zoomer->setZoomBase();
+	QwtPlotPanner *panner = new QwtPlotPanner(plot->canvas());
+	panner->setMouseButton(Qt::MidButton);
+
 	/* plot */
     	plot->show();
 
@@ -119,8 +232,7 @@ void QuickPlot(int nx, int ny, float **data)
  *	7: x=-y, y=-x
  */
 void QuickPlot_rot(int nx, int ny, void *data, int ori) {
-	int i, j, ni, nj;	
-	float **dat;
+	int ni, nj;
 
 	switch(ori) {
 	case 0: // x=x and y=y (no rotation)
@@ -159,26 +271,128 @@ void QuickPlot_rot(int nx, int ny, void *data, int ori) {
 		exit(1);	
 	}
 
-	dat = (float**)malloc(ni*sizeof(float*)); // allocate array of pointers
-	if(dat==NULL) {
-		printf("\nError allocating memory\n");
+	if (ni < 0 or nj < 0) {
+		printf("\nMirrored orientation %d is not supported\n", ori);
 		exit(1);
 	}
 
-	for(i = 0; i < ni; i++) dat[i] = (float*)malloc(nj*sizeof(float)); // allocate each row
+	/* data is already contiguous, so it is plotted without copying */
+	QuickPlot_xy(ni, nj, (const float*)data);
+}
 
-	if(dat[i-1]==NULL) {
+/* plot 2D float array (data[i] is i-th row of ny values) */
+void QuickPlot(int nx, int ny, float **data) {
+	float *dat = (float*)malloc(long(nx)*ny*sizeof(float));
+	if(dat==NULL) {
 		printf("\nError allocating memory\n");
 		exit(1);
 	}
-
-	for (i=0; i<ni; i++)
-		for (j=0; j<nj; j++)
-			dat[i][j] = ((float*)data)[i*nj+j];
-
-	QuickPlot(ni, nj, dat);
+	for (long i=0; i<nx; i++)
+		memcpy(&dat[i*ny], data[i], ny*sizeof(float));
+	QuickPlot_xy(nx, ny, dat);
+	free(dat);
 }
 
 void QuickPlot(int nx, int ny, void *data) {
 	QuickPlot_rot(nx, ny, data, 2);	
 } 
+
+/*******************
+ * offscreen output *
+ *******************/
+
+/* number of colours of file output colour tables (index QP_NCOLORS is used for NaN) */
+static const int QP_NCOLORS = 255;
+/* small fields are magnified to at least this number of pixels (larger dimension) */
+static const int QP_MIN_IMAGE_DIM = 400;
+
+/* returns colour table of colour map (built once and shared by all frames) */
+static QVector<QRgb> color_table(int colormap)
+{
+	static QMutex lock;
+	static QVector<QRgb> tables[2];
+	QMutexLocker guard(&lock);
+
+	if (colormap != QP_COLORMAP_GRAY) colormap = QP_COLORMAP_DEFAULT;
+	QVector<QRgb> &table = tables[colormap];
+	if (table.isEmpty()) {
+		QwtLinearColorMap *map;
+		if (colormap == QP_COLORMAP_GRAY) map = new QwtLinearColorMap(Qt::black, Qt::white);
+		else map = new ColorMap();
+		QwtInterval interval(0, QP_NCOLORS-1);
+		for (int i = 0; i < QP_NCOLORS; i++)
+			table.append(map->rgb(interval, i));
+		table.append(qRgb(255, 255, 255)); /* NaN */
+		delete map;
+	}
+	return table;
+}
+
+/* limits number of queued frames (each holds a copy of its data) */
+static QSemaphore *render_slots(void)
+{
+	static QSemaphore slots(4*QThread::idealThreadCount());
+	return &slots;
+}
+
+/* renders one frame into image file */
+class RenderJob: public QRunnable
+{
+public:
+    RenderJob(int nx, int ny, const float *src, QString path, QVector<QRgb> colors, float zmin, float zmax):
+        nx(nx), ny(ny), data(src, src+long(nx)*ny), path(path), colors(colors), zmin(zmin), zmax(zmax)
+    {
+    }
+
+    virtual void run()
+    {
+        if (zmin > zmax)
+            value_range(long(nx)*ny, &data[0], &zmin, &zmax);
+        int scale = qMax(1, QP_MIN_IMAGE_DIM / qMax(nx, ny));
+        double f = (zmax > zmin) ? (QP_NCOLORS-1) / double(zmax - zmin) : 0;
+
+        /* image row 0 is top, i.e. last row of data */
+        QImage image(nx*scale, ny*scale, QImage::Format_Indexed8);
+        image.setColorTable(colors);
+        for (int r = 0; r < ny*scale; r++) {
+            const float *row = &data[long(ny-1 - r/scale)*nx];
+            uchar *line = image.scanLine(r);
+            for (int c = 0; c < nx*scale; c++) {
+                float v = row[c/scale];
+                int idx = QP_NCOLORS;
+                if (v == v) idx = qBound(0, int((v - zmin)*f + 0.5), QP_NCOLORS-1);
+                line[c] = uchar(idx);
+            }
+        }
+        if (!image.save(path))
+            fprintf(stderr, "Error writing image %s\n", path.toLocal8Bit().constData());
+        render_slots()->release();
+    }
+
+private:
+    int nx, ny;
+    std::vector<float> data;
+    QString path;
+    QVector<QRgb> colors;
+    float zmin, zmax;
+};
+
+/* renders 2D float array offscreen into image file on worker pool */
+void QuickPlotToFile(int nx, int ny, const float *data, const char *path, int colormap, float zmin, float zmax)
+{
+	/* one application without GUI is shared by all frames */
+	if (!QCoreApplication::instance()) {
+		static char *argv[] = {(char*)&"Quick Plot", NULL};
+		static int argc = 1;
+		new QApplication(argc, argv, false);
+	}
+
+	render_slots()->acquire();
+	QThreadPool::globalInstance()->start(new RenderJob(nx, ny, data, QString(path), color_table(colormap), zmin, zmax));
+}
+
+/* waits until all queued images are written */
+void QuickPlotWait(void)
+{
+	QThreadPool::globalInstance()->waitForDone();
+}
@@ -12,7 +12,22 @@
 
 /* plot 2D float array */
 void QuickPlot(int nx, int ny, float **data);
+/* plot contiguous 2D float array (x fastest varying, i.e. data[j*nx+i]) */
+void QuickPlot_xy(int nx, int ny, const float *data);
+/* as above with given colour scale range (e.g. from a SIMD reduction of the caller) */
+void QuickPlot_xy(int nx, int ny, const float *data, float zmin, float zmax);
 void QuickPlot(int nx, int ny, void *data);
 void QuickPlot_rot(int nx, int ny, void *data, int ori);
 
+/* colour maps of file output */
+enum QuickPlotColorMap { QP_COLORMAP_DEFAULT = 0, QP_COLORMAP_GRAY = 1 };
+/* Renders contiguous 2D float array (x fastest varying) offscreen into image file
+ * (format given by suffix of path, e.g. .png). Data is copied and rendered on a
+ * worker pool, i.e. the call returns immediately (QuickPlotWait() waits for all
+ * images). zmin > zmax computes the colour scale range from data.
+ */
+void QuickPlotToFile(int nx, int ny, const float *data, const char *path,
+		int colormap = QP_COLORMAP_DEFAULT, float zmin = 1, float zmax = 0);
+void QuickPlotWait(void);
+
 #endif /* QUICKPLOT_H_ */
@@ -0,0 +1,143 @@
+/*
+ * GEO_crop.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Roman Finkelnburg
+ *   Copyright: Roman Finkelnburg (2026)
+ * Description: This tool crops a sub-window out of a geogrid input file and
+ *              optionally downsamples it.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <math.h>
+
+#include "libutils.h"
+#include "libgeo.h"
+
+using namespace std;
+
+void print_help(void) {
+	cout << "COMMAND: GEO_crop <input file> <output file> --window=<x0>,<y0>,<nx>,<ny>\n";
+	cout << "OPIONS:  --level=<level>		Crop only this level (default: all levels).\n";
+	cout << "         --factor=<n>		Downsample window by factor n.\n";
+	cout << "         --method=<method>	Downsampling method: nearest (default) or mean.\n";
+	cout << "         --index		Additionally write index file.\n";
+}
+
+int main(int argc, char** argv) {
+	string ifilename, ofilename, method = "nearest";
+	int x0, y0, nx, ny;
+	int level = -1;
+	int fac = 1;
+	bool copy_index = false;
+	bool f_window = false;
+
+	/*********************************
+	 * Checking/extracting arguments *
+	 *********************************/
+	if (argc < 4 or argc > 8) {
+		print_help();
+		return EXIT_FAILURE;
+	}
+	ifilename = string(argv[1]); /* extract input filename */
+	ofilename = string(argv[2]); /* extract output filename */
+	for (int n=3; n<argc; n++) {
+		string arg = string(argv[n]);
+		if (!arg.compare(0,strlen("--window="),"--window=")) {
+			if (sscanf(arg.substr(strlen("--window=")).c_str(), "%i,%i,%i,%i", &x0, &y0, &nx, &ny) != 4) {
+				cout << "Window unknown (should be --window=<x0>,<y0>,<nx>,<ny>)\n";
+				print_help();
+				return EXIT_FAILURE;
+			}
+			f_window = true;
+		} else if (!arg.compare(0,strlen("--level="),"--level=")) {
+			level = atoi(arg.substr(strlen("--level=")).c_str());
+		} else if (!arg.compare(0,strlen("--factor="),"--factor=")) {
+			fac = atoi(arg.substr(strlen("--factor=")).c_str());
+		} else if (!arg.compare(0,strlen("--method="),"--method=")) {
+			method = arg.substr(strlen("--method="));
+		} else if (!arg.compare(0,strlen("--index"),"--index")) {
+			copy_index = true;
+		} else {
+			cout << "Argument unknown: " << arg << endl;
+			print_help();
+			return EXIT_FAILURE;
+		}
+	}
+	if (!f_window) {
+		cout << "Missing argument --window=<x0>,<y0>,<nx>,<ny>\n";
+		print_help();
+		return EXIT_FAILURE;
+	}
+	if (fac < 1 or fac > nx or fac > ny) {
+		cout << "ABORT: Downsampling factor " << fac << " not supported for " << nx << "x" << ny << " window!\n";
+		return EXIT_FAILURE;
+	}
+	if (method != "nearest" and method != "mean") {
+		cout << "Method unknown (should be nearest or mean)\n";
+		print_help();
+		return EXIT_FAILURE;
+	}
+
+	/**************
+	 * Open files *
+	 **************/
+
+	/* open original geogrid file (only header is loaded, window is read on demand) */
+	Geogrid geo_in(ifilename, false, false);
+	Geoheader header = *geo_in.get_header();
+
+	/* opening output geogrid file */
+	Geogrid geo_out(ofilename, true);
+
+	/******************************
+	 * Crop and downsample levels *
+	 ******************************/
+	int zfirst = (level < 0) ? 0 : level;
+	int nz = (level < 0) ? header.tile_z : 1;
+	size_t nxo = nx/fac;
+	size_t nyo = ny/fac;
+	float *data = (float *)malloc(sizeof(float)*nxo*nyo*nz);
+
+	cout << "Cropping data file ...\n";
+	for (int z=0; z<nz; z++) {
+		float *win = geo_in.read_window(x0, y0, nx, ny, zfirst+z);
+		float *out = &data[z*nxo*nyo];
+		if (method == "mean") {
+			downsample_mean(nx, ny, win, fac, out);
+			for (size_t i=0; i<nxo*nyo; i++) out[i] = floorf(out[i]+0.5);
+		} else {
+			downsample_nearest(nx, ny, win, fac, out);
+		}
+		free(win);
+	}
+
+	/* adjust header to cropped (and downsampled) grid */
+	float off = (method == "mean") ? 0.5*(fac-1) : float(fac/2);
+	header.known_x = (header.known_x-(x0-header.tile_bdr+1)-off)/fac+1;
+	header.known_y = (header.known_y-(y0-header.tile_bdr+1)-off)/fac+1;
+	header.dx *= fac;
+	header.dy *= fac;
+	header.tile_x = nxo;
+	header.tile_y = nyo;
+	header.tile_z = nz;
+	header.tile_bdr = 0;
+	geo_out.set_header(&header);
+
+	/* write index file if requested */
+	if (copy_index) {
+		cout << "Writing index file ...\n";
+		geo_out.write_indexfile();
+	}
+
+	/* write data file */
+	cout << "Writing data file ...\n";
+	geo_out.set_data(data, nxo*nyo*nz);
+	geo_out.write_datafile();
+	free(data);
+
+	return EXIT_SUCCESS;
+}
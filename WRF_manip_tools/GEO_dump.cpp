@@ -21,35 +21,55 @@ using namespace std;
 void print_help(void) {
 	cout << "COMMAND: GEO_dump <file>\n";
 	cout << "OPIONS:  --level=<level>	Plots data for this level.\n";
+	cout << "         --png=<dir>		Render all levels (or selected level) into PNG files <dir>/<file>_<level>.png instead.\n";
 }
 
 int main(int argc, char** argv) {
-	bool endian = true; /* play around with this flag to handle endian problems */
-	string filename;
+	string filename, pngdir;
 	int level = 0;
+	bool f_level = false;
 
-	if (argc < 2 or argc > 3) {
+	if (argc < 2 or argc > 4) {
 		print_help();
 		return EXIT_FAILURE;
-	} else {
-		filename = string(argv[1]); /* extract filename */
-		if (argc == 3) {
-			if (string(argv[2]).compare(0,strlen("--level="),"--level=")) {
-				cout << "Second argument unknown (should be --level=<level>)\n";
-				print_help();
-				return EXIT_FAILURE;
-			} else {
-				/* level to be plotted*/
-				level = atoi(((string(argv[2])).substr(strlen("--level="),strlen(argv[2])-strlen("--level="))).c_str());
-			}
+	}
+	filename = string(argv[1]); /* extract filename */
+	for (int n=2; n<argc; n++) {
+		string arg = string(argv[n]);
+		if (!arg.compare(0,strlen("--level="),"--level=")) {
+			/* level to be plotted*/
+			level = atoi(arg.substr(strlen("--level=")).c_str());
+			f_level = true;
+		} else if (!arg.compare(0,strlen("--png="),"--png=")) {
+			/* directory of rendered images */
+			pngdir = arg.substr(strlen("--png="));
+		} else {
+			cout << "Argument unknown: " << arg << endl;
+			print_help();
+			return EXIT_FAILURE;
 		}
 	}
 
 	/* load geogrid file */
 	Geogrid geo(filename);
 
-	/* dump loaded data */
-	geo.dump(level);
+	/* dump loaded data or render levels into images */
+	if (pngdir.empty()) {
+		geo.dump(level);
+	} else {
+		Geoheader *h = geo.get_header();
+		int nx = h->tile_x+2*h->tile_bdr;
+		int ny = h->tile_y+2*h->tile_bdr;
+		string base = filename.substr(filename.find_last_of('/')+1);
+		for (int z = 0; z < h->tile_z; z++) {
+			if (f_level and z != level) continue;
+			float *lvl = &geo.get_data()[size_t(z)*nx*ny];
+			float zmin, zmax;
+			vec_minmax(size_t(nx)*ny, lvl, &zmin, &zmax, true);
+			QuickPlotToFile(nx, ny, lvl, (pngdir+"/"+base+"_"+to_string(z)+".png").c_str(), QP_COLORMAP_DEFAULT, zmin, zmax);
+		}
+		QuickPlotWait();
+	}
 
 	return EXIT_SUCCESS;
 }
@@ -16,7 +16,6 @@
 using namespace std;
 
 int main(int argc, char** argv) {
-	bool endian = true; /* play around with this flag to handle endian problems */
 	string ifilename, ofilename;
 	int ok;
 
@@ -56,7 +55,6 @@ int main(int argc, char** argv) {
 	struct IFFheader header;
 	struct IFFproj proj;
 	int is_wind_grid_rel;
-	float **data;
 
 	while(!ifile.eof()) {
 		/* reading version information */
@@ -64,21 +62,21 @@ int main(int argc, char** argv) {
 		if (ifile.eof()) { /* exit if EOF */
 			break;
 		}
-		ifile.read(dummy,4);header.version = b2i(dummy, endian);
+		ifile.read(dummy,4);header.version = decode<ENDIAN_IFF,int>(dummy);
 		ifile.read(dummy,4);
 
 		/* reading header information */
 		ifile.read(dummy,4);
 		ifile.read(header.hdate,24);header.hdate[24] = '\0';
-		ifile.read(dummy,4); header.xfcst = b2f(dummy, endian);
+		ifile.read(dummy,4); header.xfcst = decode<ENDIAN_IFF,float>(dummy);
 		ifile.read(header.map_source,32); header.map_source[32] = '\0';
 		ifile.read(header.field,9); header.field[9] = '\0';
 		ifile.read(header.units,25); header.units[25] = '\0';
 		ifile.read(header.desc,46); header.desc[46] = '\0';
-		ifile.read(dummy,4); header.xlvl = b2f(dummy, endian);
-		ifile.read(dummy,4); proj.nx = b2i(dummy, endian);
-		ifile.read(dummy,4); proj.ny = b2i(dummy, endian);
-		ifile.read(dummy,4); proj.iproj = b2i(dummy, endian);
+		ifile.read(dummy,4); header.xlvl = decode<ENDIAN_IFF,float>(dummy);
+		ifile.read(dummy,4); proj.nx = decode<ENDIAN_IFF,int>(dummy);
+		ifile.read(dummy,4); proj.ny = decode<ENDIAN_IFF,int>(dummy);
+		ifile.read(dummy,4); proj.iproj = decode<ENDIAN_IFF,int>(dummy);
 		ifile.read(dummy,4);
 
         /* reading projection information */
@@ -86,57 +84,57 @@ int main(int argc, char** argv) {
 		case 0 : /* Cylindrical equidistant */
 			ifile.read(dummy,4);
 			ifile.read(proj.startloc,8); proj.startloc[8] = '\0';
-			ifile.read(dummy,4); proj.startlat = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.startlon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.deltalat = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.deltalon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.earth_radius = b2f(dummy, endian);
+			ifile.read(dummy,4); proj.startlat = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.startlon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.deltalat = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.deltalon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			ifile.read(dummy,4);
 			break;
 		case 1 : /* Mercator */
 			ifile.read(dummy,4);
 			ifile.read(proj.startloc,8); proj.startloc[8] = '\0';
-			ifile.read(dummy,4); proj.startlat = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.startlon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.dx = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.dy = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.truelat1 = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.earth_radius = b2f(dummy, endian);
+			ifile.read(dummy,4); proj.startlat = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.startlon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.dx = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.dy = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.truelat1 = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			ifile.read(dummy,4);
 			break;
 		case 3 : /* Lambert conformal */
 			ifile.read(dummy,4);
 			ifile.read(proj.startloc,8); proj.startloc[8] = '\0';
-			ifile.read(dummy,4); proj.startlat = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.startlon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.dx = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.dy = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.xlonc = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.truelat1 = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.truelat2 = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.earth_radius = b2f(dummy, endian);
+			ifile.read(dummy,4); proj.startlat = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.startlon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.dx = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.dy = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.xlonc = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.truelat1 = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.truelat2 = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			ifile.read(dummy,4);
 			break;
 		case 4 : /* Gaussian */
 			ifile.read(dummy,4);
 			ifile.read(proj.startloc,8); proj.startloc[8] = '\0';
-			ifile.read(dummy,4); proj.startlat = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.startlon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.nlats = b2i(dummy, endian);
-			ifile.read(dummy,4); proj.deltalon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.earth_radius = b2f(dummy, endian);
+			ifile.read(dummy,4); proj.startlat = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.startlon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.nlats = decode<ENDIAN_IFF,int>(dummy);
+			ifile.read(dummy,4); proj.deltalon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			ifile.read(dummy,4);
 			break;
 		case 5 : /* Polar stereographic */
 			ifile.read(dummy,4);
 			ifile.read(proj.startloc,8); proj.startloc[8] = '\0';
-			ifile.read(dummy,4); proj.startlat = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.startlon = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.dx = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.dy = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.xlonc = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.truelat1 = b2f(dummy, endian);
-			ifile.read(dummy,4); proj.earth_radius = b2f(dummy, endian);
+			ifile.read(dummy,4); proj.startlat = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.startlon = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.dx = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.dy = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.xlonc = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.truelat1 = decode<ENDIAN_IFF,float>(dummy);
+			ifile.read(dummy,4); proj.earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			ifile.read(dummy,4);
 			break;
 		default:
@@ -147,21 +145,17 @@ int main(int argc, char** argv) {
 		/* reading wind flag (flag indicates whether winds are relative to source grid (TRUE) or
 		   relative to earth (FALSE) */
 		ifile.read(dummy,4);
-		ifile.read(dummy,4); is_wind_grid_rel = b2i(dummy, endian);
+		ifile.read(dummy,4); is_wind_grid_rel = decode<ENDIAN_IFF,int>(dummy);
 		ifile.read(dummy,4);
 
-		/* reading data */
-		data = allocate2D(proj.nx, proj.ny);
+		/* reading data (whole block is read and decoded at once) */
+		Field2D<float> data(proj.nx, proj.ny, &buffer_pool());
 		ifile.read(dummy,4);
-		for (int j=0; j<proj.ny; j++) {
-			for (int i=0; i<proj.nx; i++) {
-				ifile.read(dummy,4); data[i][j] = b2f(dummy, endian);
-			}
-		}
+		ifile.read((char *)data.data(), data.bytes());
+		decode_n<ENDIAN_IFF>(data.data(), data.data(), data.size());
 		ifile.read(dummy,4);
 
-		ok = write_IFF(&ofile, endian, header, proj, is_wind_grid_rel, data);
-		free(data);
+		ok = write_IFF<ENDIAN_IFF>(&ofile, header, proj, is_wind_grid_rel, data);
 	}
 
 	ofile.close();
@@ -20,45 +20,47 @@ void print_help(void) {
 	puts("COMMAND: IFF_dump <file>");
 	puts("OPIONS:  --variable=<variable> Dump only 'this' variable.");
 	puts("         --plot=<level>        Additionally plot data for 'this' variable at pressure level.");
+	puts("         --png=<dir>           Render data of all (or selected) records into PNG files <dir>/<field>_<level>_<date>.png.");
 }
 
 int main(int argc, char** argv) {
-	bool endian = true; /* play around with this flag to handle endian problems */
-	string filename, variable;
-	double level;
-	bool f_var, f_plot;
+	string filename, variable, pngdir;
+	double level = 0;
+	bool f_var = false;
+	bool f_plot = false;
 
 	/*********************************
 	 * Checking/extracting arguments *
 	 *********************************/
-	if (argc < 2 or argc > 4) {
+	if (argc < 2 or argc > 5) {
 		print_help();
 		return EXIT_FAILURE;
-	} else {
-		filename = string(argv[1]); /* extract filename */
-		if (argc > 2) {
-			if (string(argv[2]).compare(0,strlen("--variable="),"--variable=")) {
-				puts("Second argument unknown (should be --variable=<variable>)");
-				print_help();
-				return EXIT_FAILURE;
-			} else {
-				/* extract variable name */
-				variable = (string(argv[2])).substr(strlen("--variable="),strlen(argv[2])-strlen("--variable="));
-				f_var = true;
-			}
-		}
-		if (argc == 4) {
-			if (string(argv[3]).compare(0,strlen("--plot="),"--plot=")) {
-				puts("Third argument unknown (should be --plot=<level>)");
-				print_help();
-				return EXIT_FAILURE;
-			} else {
-				/* pressure level to be plotted*/
-				level = atof(((string(argv[3])).substr(strlen("--plot="),strlen(argv[3])-strlen("--plot="))).c_str());
-				f_plot = true;
-			}
+	}
+	filename = string(argv[1]); /* extract filename */
+	for (int n=2; n<argc; n++) {
+		string arg = string(argv[n]);
+		if (!arg.compare(0,strlen("--variable="),"--variable=")) {
+			/* extract variable name */
+			variable = arg.substr(strlen("--variable="));
+			f_var = true;
+		} else if (!arg.compare(0,strlen("--plot="),"--plot=")) {
+			/* pressure level to be plotted*/
+			level = atof(arg.substr(strlen("--plot=")).c_str());
+			f_plot = true;
+		} else if (!arg.compare(0,strlen("--png="),"--png=")) {
+			/* directory of rendered images */
+			pngdir = arg.substr(strlen("--png="));
+		} else {
+			cout << "Argument unknown: " << arg << endl;
+			print_help();
+			return EXIT_FAILURE;
 		}
 	}
+	if (f_plot and !f_var) {
+		puts("--plot=<level> requires --variable=<variable>");
+		print_help();
+		return EXIT_FAILURE;
+	}
 
 	/***************************************************************
 	 * Reading Intermediate Format File (unformatted Fortran file) *
@@ -77,7 +79,6 @@ int main(int argc, char** argv) {
 	float startlat, startlon, deltalat, deltalon, dx, dy, xlonc, truelat1, truelat2, earth_radius;
 	char is_wind_grid_rel[5];
 	bool found = false;
-	float **data;
 
 	ifstream file;
 	file.open(filename.c_str(), ios::in);
@@ -92,21 +93,21 @@ int main(int argc, char** argv) {
 		if (file.eof()) { /* exit if EOF */
 			break;
 		}
-		file.read(dummy,4); version = b2i(dummy, endian);
+		file.read(dummy,4); version = decode<ENDIAN_IFF,int>(dummy);
 		file.read(dummy,4);
 
 		/* reading header information */
 		file.read(dummy,4);
 		file.read(hdate,24);hdate[24] = '\0';
-		file.read(dummy,4); xfcst = b2f(dummy, endian);
+		file.read(dummy,4); xfcst = decode<ENDIAN_IFF,float>(dummy);
 		file.read(map_source,32); map_source[32] = '\0';
 		file.read(field,9); field[9] = '\0';
 		file.read(units,25); units[25] = '\0';
 		file.read(desc,46); desc[46] = '\0';
-		file.read(dummy,4); xlvl = b2f(dummy, endian);
-		file.read(dummy,4); nx = b2i(dummy, endian);
-		file.read(dummy,4); ny = b2i(dummy, endian);
-		file.read(dummy,4); iproj = b2i(dummy, endian);
+		file.read(dummy,4); xlvl = decode<ENDIAN_IFF,float>(dummy);
+		file.read(dummy,4); nx = decode<ENDIAN_IFF,int>(dummy);
+		file.read(dummy,4); ny = decode<ENDIAN_IFF,int>(dummy);
+		file.read(dummy,4); iproj = decode<ENDIAN_IFF,int>(dummy);
 		file.read(dummy,4);
 
 		if (f_var) {
@@ -141,11 +142,11 @@ int main(int argc, char** argv) {
 		case 0 : /* Cylindrical equidistant */
 			file.read(dummy,4);
 			file.read(startloc,8); startloc[8] = '\0';
-			file.read(dummy,4); startlat = b2f(dummy, endian);
-			file.read(dummy,4); startlon = b2f(dummy, endian);
-			file.read(dummy,4); deltalat = b2f(dummy, endian);
-			file.read(dummy,4); deltalon = b2f(dummy, endian);
-			file.read(dummy,4); earth_radius = b2f(dummy, endian);
+			file.read(dummy,4); startlat = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); startlon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); deltalat = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); deltalon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			file.read(dummy,4);
 			if (found) {
 				cout << "IPROJ = " << iproj << " (Cylindrical equidistant)" << endl;
@@ -158,12 +159,12 @@ int main(int argc, char** argv) {
 		case 1 : /* Mercator */
 			file.read(dummy,4);
 			file.read(startloc,8); startloc[8] = '\0';
-			file.read(dummy,4); startlat = b2f(dummy, endian);
-			file.read(dummy,4); startlon = b2f(dummy, endian);
-			file.read(dummy,4); dx = b2f(dummy, endian);
-			file.read(dummy,4); dy = b2f(dummy, endian);
-			file.read(dummy,4); truelat1 = b2f(dummy, endian);
-			file.read(dummy,4); earth_radius = b2f(dummy, endian);
+			file.read(dummy,4); startlat = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); startlon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); dx = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); dy = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); truelat1 = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			file.read(dummy,4);
 			if (found) {
 				cout << "IPROJ = " << iproj << " (Mercator)" << endl;
@@ -177,14 +178,14 @@ int main(int argc, char** argv) {
 		case 3 : /* Lambert conformal */
 			file.read(dummy,4);
 			file.read(startloc,8); startloc[8] = '\0';
-			file.read(dummy,4); startlat = b2f(dummy, endian);
-			file.read(dummy,4); startlon = b2f(dummy, endian);
-			file.read(dummy,4); dx = b2f(dummy, endian);
-			file.read(dummy,4); dy = b2f(dummy, endian);
-			file.read(dummy,4); xlonc = b2f(dummy, endian);
-			file.read(dummy,4); truelat1 = b2f(dummy, endian);
-			file.read(dummy,4); truelat2 = b2f(dummy, endian);
-			file.read(dummy,4); earth_radius = b2f(dummy, endian);
+			file.read(dummy,4); startlat = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); startlon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); dx = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); dy = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); xlonc = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); truelat1 = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); truelat2 = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			file.read(dummy,4);
 			if (found) {
 				cout << "IPROJ = " << iproj << " (Lambert conformal)" << endl;
@@ -199,11 +200,11 @@ int main(int argc, char** argv) {
 		case 4 : /* Gaussian */
 			file.read(dummy,4);
 			file.read(startloc,8); startloc[8] = '\0';
-			file.read(dummy,4); startlat = b2f(dummy, endian);
-			file.read(dummy,4); startlon = b2f(dummy, endian);
-			file.read(dummy,4); nlats = b2i(dummy, endian);
-			file.read(dummy,4); deltalon = b2f(dummy, endian);
-			file.read(dummy,4); earth_radius = b2f(dummy, endian);
+			file.read(dummy,4); startlat = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); startlon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); nlats = decode<ENDIAN_IFF,int>(dummy);
+			file.read(dummy,4); deltalon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			file.read(dummy,4);
 			if (found) {
 				cout << "IPROJ = " << iproj << " (Gaussian)" << endl;
@@ -217,13 +218,13 @@ int main(int argc, char** argv) {
 		case 5 : /* Polar stereographic */
 			file.read(dummy,4);
 			file.read(startloc,8); startloc[8] = '\0';
-			file.read(dummy,4); startlat = b2f(dummy, endian);
-			file.read(dummy,4); startlon = b2f(dummy, endian);
-			file.read(dummy,4); dx = b2f(dummy, endian);
-			file.read(dummy,4); dy = b2f(dummy, endian);
-			file.read(dummy,4); xlonc = b2f(dummy, endian);
-			file.read(dummy,4); truelat1 = b2f(dummy, endian);
-			file.read(dummy,4); earth_radius = b2f(dummy, endian);
+			file.read(dummy,4); startlat = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); startlon = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); dx = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); dy = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); xlonc = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); truelat1 = decode<ENDIAN_IFF,float>(dummy);
+			file.read(dummy,4); earth_radius = decode<ENDIAN_IFF,float>(dummy);
 			file.read(dummy,4);
 			if (found) {
 				cout << "IPROJ = " << iproj << " (Polar stereographic)" << endl;
@@ -246,34 +247,44 @@ int main(int argc, char** argv) {
 		file.read(is_wind_grid_rel,4); is_wind_grid_rel[4] = '\0';
 		file.read(dummy,4);
 
-		/* reading data */
-		data = allocate2D(nx, ny);
-		void *data_tmp = malloc(sizeof(float)*nx*ny);
+		/* reading data (whole block is read and decoded at once) */
+		Field2D<float> data(nx, ny);
 		file.read(dummy,4);
-		for (int j=0; j<ny; j++) {
-			for (int i=0; i<nx; i++) {
-				file.read(dummy,4); data[i][j] = b2f(dummy, endian);
-				((float *) data_tmp)[j*nx+i] = b2f(dummy, endian);
-			}
-		}
+		file.read((char *)data.data(), data.bytes());
+		decode_n<ENDIAN_IFF>(data.data(), data.data(), data.size());
 		file.read(dummy,4);
 
 		/* output first data element */
 		if (found) {
-			cout << "DATA(1,1) = " << data[0][0] << endl;
+			cout << "DATA(1,1) = " << data(0,0) << endl;
 			if (f_plot and level == xlvl) { /* plot if requested */
 #ifdef QUICKPLOT_H_
-	QuickPlot_rot(nx, ny, data_tmp, 0);
+	float zmin, zmax;
+	vec_minmax(data.size(), data.data(), &zmin, &zmax, true);
+	QuickPlot_xy(nx, ny, data.data(), zmin, zmax);
+#else
+	cout << "Plot option was not compiled!\n";
+#endif
+			}
+			if (!pngdir.empty()) { /* render image if requested */
+#ifdef QUICKPLOT_H_
+	char name[128];
+	snprintf(name, sizeof(name), "/%s_%.0f_%s.png", edge_crop(string(field), ' ').c_str(), xlvl, edge_crop(string(hdate), ' ').c_str());
+	float zmin, zmax;
+	vec_minmax(data.size(), data.data(), &zmin, &zmax, true);
+	QuickPlotToFile(nx, ny, data.data(), (pngdir+name).c_str(), QP_COLORMAP_DEFAULT, zmin, zmax);
 #else
 	cout << "Plot option was not compiled!\n";
 #endif
 			}
 		}
 
-		free(data);
 		found = false;
 	}
 
 	file.close();
+#ifdef QUICKPLOT_H_
+	if (!pngdir.empty()) QuickPlotWait(); /* wait for rendered images */
+#endif
 	return EXIT_SUCCESS;
 }
@@ -10,28 +10,466 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <sstream>
+#include <fstream>
 #include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <map>
+#include <sys/stat.h>
+#include <ctime>
 #include "libutils.h"
 #include "libiff.h"
 #include "libwrf.h"
+#include "libgrid.h"
 
 using namespace std;
 
 /* print help text */
 void print_help(void) {
 	cout << "COMMAND: WRF2IFF <WRF file> <ouput directory>\n";
+	cout << "OPIONS:  --levels=<spec> Output levels of 3D fields (default: all 26 standard pressure levels):\n";
+	cout << "                         pressure[:<hPa>,...]  pressure levels (subset of the defaults or any other)\n";
+	cout << "                         agl:<m>,...           heights above ground (written with PRESSURE field)\n";
+	cout << "                         native[:<n>,...]      model levels without interpolation (default: all levels,\n";
+	cout << "                                               written with PRESSURE field, level code is level number)\n";
+	cout << "                         @<file>               specification read from file (whitespace separates values)\n";
+	cout << "         --cache=<dir>   Directory caching time invariant fields (SOILHGT, LANDSEA) of the domain\n";
+	cout << "                         for later files (default: no cache).\n";
+	cout << "         --resume        Incremental conversion: time steps recorded as complete in <ouput directory>/\n";
+	cout << "                         WRF2IFF.manifest with the same options are skipped (e.g. rerun after failure or\n";
+	cout << "                         on a growing WRF file).\n";
+	cout << "         --follow[=<s>]  Follow WRF file written by a running simulation: time steps are converted as soon\n";
+	cout << "                         as they are complete (next time step started or file closed by WRF), following\n";
+	cout << "                         ends when the file was not modified for <s> seconds (default: 3600).\n";
+	cout << "         --regrid=<grid> Regrid records horizontally to target grid (e.g. child domain) given by\n";
+	cout << "                         <geo_em file>                                 grid of geogrid output (XLAT_M/XLONG_M)\n";
+	cout << "                         latlon:<lat0>,<lon0>,<dlat>,<dlon>,<nx>,<ny>  regular lat/lon grid from south west\n";
+	cout << "                                                                       corner lat0/lon0 in degrees\n";
+	cout << "                         (Lambert/polar stereographic WRF grids: same projection required, winds are grid relative)\n";
+	cout << "         --regrid-method=<bilinear|conservative>\n";
+	cout << "                         Regridding weights (default: bilinear, conservative: area weighted average).\n";
+	cout << "         --window=<i0>,<j0>,<ni>,<nj>\n";
+	cout << "                         Convert only ni x nj grid points starting at 0-based index i0/j0 (west_east/\n";
+	cout << "                         south_north) of the WRF grid (default: all).\n";
+	cout << "         --bbox=<lat0>,<lon0>,<lat1>,<lon1>\n";
+	cout << "                         Convert only the index window covering the grid points within lat0-lat1 and\n";
+	cout << "                         lon0-lon1 in degrees plus one point on each side (e.g. child domain).\n";
+	cout << "         --agl=<list>    Comma separated heights above ground [m] of additional wind records\n";
+	cout << "                         (UU/VV/WW named e.g. UU080M for 80 m, written with the surface records).\n";
+}
+
+/* vertical coordinate of 3D output levels */
+enum LevelCoord {
+	LEVELS_PRESSURE,	// pressure levels [Pa]
+	LEVELS_AGL,			// heights above ground [m]
+	LEVELS_NATIVE		// model (bottom_top) levels, numbered from 1 at the lowest level
+};
+
+/* default output pressure levels [hPa] */
+const float DEFAULT_PLVL[26] = {1000.0, 975.0, 950.0, 925.0, 900.0, 850.0, 800.0, 750.0, 700.0, 650.0, 600.0, 550.0, 500.0,
+		450.0, 400.0, 350.0, 300.0, 250.0, 200.0, 150.0, 100.0, 70.0, 50.0, 30.0, 20.0, 10.0};
+
+/* parses output level specification <coordinate>[:<value>,...] or @<file> holding it
+ * (pressure levels are returned in Pa, heights above ground in m, model levels as numbers) */
+void parse_levels(string spec, LevelCoord *coord, vector<float> *levels) {
+	if (!spec.empty() and spec[0] == '@') {
+		ifstream ifile(spec.substr(1).c_str());
+		if (!ifile.is_open()) {
+			cout << "ABORT: Cannot open level specification " << spec.substr(1) << "!\n";
+			exit(EXIT_FAILURE);
+		}
+		string line, word;
+		spec.clear();
+		while (getline(ifile, line)) {
+			if (line.empty() or line[0] == '#') continue;
+			istringstream iss(line);
+			while (iss >> word) spec += (spec.empty() or spec[spec.size()-1] == ':' or word[0] == ':') ? word : ","+word;
+		}
+	}
+
+	string name = spec.substr(0, spec.find(':'));
+	string list = (spec.find(':') == string::npos) ? "" : spec.substr(spec.find(':')+1);
+	float scale;
+	if (name == "pressure") {
+		*coord = LEVELS_PRESSURE;
+		scale = 100.0; // hPa -> Pa
+	} else if (name == "agl") {
+		*coord = LEVELS_AGL;
+		scale = 1.0;
+	} else if (name == "native") {
+		*coord = LEVELS_NATIVE;
+		scale = 1.0;
+	} else {
+		cout << "ABORT: Unknown vertical coordinate " << name << " in level specification!\n";
+		exit(EXIT_FAILURE);
+	}
+
+	levels->clear();
+	stringstream iss(list);
+	string item;
+	while (getline(iss, item, ',')) {
+		if (item.empty()) continue;
+		char *end;
+		float val = strtof(item.c_str(), &end);
+		if (*end != '\0' or val <= 0) {
+			cout << "ABORT: Invalid level " << item << " in level specification!\n";
+			exit(EXIT_FAILURE);
+		}
+		levels->push_back(val*scale);
+	}
+	if (levels->empty()) {
+		if (*coord == LEVELS_NATIVE) return; /* all model levels (number is not known yet) */
+		if (*coord != LEVELS_PRESSURE) {
+			cout << "ABORT: Level specification " << name << " requires a list of levels!\n";
+			exit(EXIT_FAILURE);
+		}
+		for (int l=0; l<26; l++) levels->push_back(DEFAULT_PLVL[l]*scale);
+	}
+}
+
+/* sets IFF projection of WRF or geogrid file (latvar/lonvar give south west corner)
+ * WRF MAP_PROJ	IFF iproj
+ *	1 Lambert conformal		3
+ *	2 polar stereographic	5
+ *	3 Mercator				1
+ *	6 lat/lon (unrotated)	0 (cylindrical equidistant)
+ */
+void read_proj(WRFncdf *wrf, string latvar, string lonvar, IFFproj *proj) {
+	int map_proj = wrf->gattval(wrf->gattid("MAP_PROJ")).i;
+	*proj = IFFproj(); /* fields not used by projection are zero */
+	switch (map_proj) {
+	case 1 : proj->iproj = 3; break;
+	case 2 : proj->iproj = 5; break;
+	case 3 : proj->iproj = 1; break;
+	case 6 : proj->iproj = 0; break;
+	default:
+		cout << "ABORT: Projection " << map_proj << " of " << wrf->getname() << " not supported!\n";
+		exit(EXIT_FAILURE);
+	}
+	cp_string(proj->startloc, 9, "SWCORNER", strlen("SWCORNER"));
+	/* only the south west corner of lat/lon is read */
+	size_t start_sw[3] = {0,0,0}, count_sw[3] = {1,1,1};
+	wrf->vardata(latvar, start_sw, count_sw, &proj->startlat);
+	wrf->vardata(lonvar, start_sw, count_sw, &proj->startlon);
+	proj->earth_radius = 6371220.0;
+	proj->nx = wrf->dimlen(wrf->dimid("west_east"));
+	proj->ny = wrf->dimlen(wrf->dimid("south_north"));
+
+	if (proj->iproj == 0) {
+		/* rotated lat/lon grids (pole not at 90N) have no IFF projection */
+		int pole = wrf->gattid("POLE_LAT");
+		if (pole < wrf->ngatts() and fabs(wrf->gattval(pole).f-90.0) > 0.001) {
+			cout << "ABORT: Rotated lat/lon projection (POLE_LAT = " << wrf->gattval(pole).f << ") of "
+					<< wrf->getname() << " not supported!\n";
+			exit(EXIT_FAILURE);
+		}
+		if (proj->nx < 2 or proj->ny < 2) {
+			cout << "ABORT: Lat/lon projection of " << wrf->getname() << " requires at least 2x2 grid points!\n";
+			exit(EXIT_FAILURE);
+		}
+		/* grid increments [deg] from neighbours of south west corner */
+		float lat1, lon1;
+		size_t start_n[3] = {0,1,0}, start_e[3] = {0,0,1};
+		wrf->vardata(latvar, start_n, count_sw, &lat1);
+		wrf->vardata(lonvar, start_e, count_sw, &lon1);
+		proj->deltalat = lat1-proj->startlat;
+		proj->deltalon = lon1-proj->startlon;
+		if (proj->deltalon < 0) proj->deltalon += 360.0; /* date line between corner and neighbour */
+		return;
+	}
+	proj->dx = wrf->gattval(wrf->gattid("DX")).f;
+	proj->dy = wrf->gattval(wrf->gattid("DY")).f;
+	proj->truelat1 = wrf->gattval(wrf->gattid("TRUELAT1")).f;
+	if (proj->iproj != 1) proj->xlonc = wrf->gattval(wrf->gattid("STAND_LON")).f;
+	if (proj->iproj == 3) proj->truelat2 = wrf->gattval(wrf->gattid("TRUELAT2")).f;
+}
+
+/* reads first time step of 2D variable (e.g. XLAT, all values if variable has no time dimension) */
+vector<float> read_2d(WRFncdf *wrf, string vname) {
+	int ndims = wrf->varndims(vname);
+	size_t *dims = wrf->vardims(vname);
+	size_t start[3] = {0,0,0}, count[3] = {1,1,1};
+	for (int d=max(ndims-2, 0); d<ndims; d++) count[d] = wrf->dimlen(dims[d]);
+	vector<float> data(count[0]*count[1]*count[2]);
+	wrf->vardata(vname, start, count, &data[0]);
+	return data;
+}
+
+/* sets target grid of regridding from geogrid file or latlon:<lat0>,<lon0>,<dlat>,<dlon>,<nx>,<ny> */
+void read_target(string spec, IFFproj *proj, vector<float> *lat, vector<float> *lon) {
+	if (!spec.compare(0,strlen("latlon:"),"latlon:")) {
+		stringstream list(spec.substr(strlen("latlon:")));
+		string item;
+		vector<double> v;
+		while (getline(list, item, ',')) v.push_back(atof(item.c_str()));
+		if (v.size() != 6 or v[2] <= 0 or v[3] <= 0 or v[4] < 2 or v[5] < 2) {
+			cout << "ABORT: Target grid " << spec << " not supported (latlon:<lat0>,<lon0>,<dlat>,<dlon>,<nx>,<ny>)!\n";
+			exit(EXIT_FAILURE);
+		}
+		*proj = IFFproj();
+		proj->iproj = 0;
+		cp_string(proj->startloc, 9, "SWCORNER", strlen("SWCORNER"));
+		proj->startlat = v[0];
+		proj->startlon = v[1];
+		proj->deltalat = v[2];
+		proj->deltalon = v[3];
+		proj->earth_radius = 6371220.0;
+		proj->nx = v[4];
+		proj->ny = v[5];
+		lat->resize(proj->nx*proj->ny);
+		lon->resize(proj->nx*proj->ny);
+		for (long j=0; j<proj->ny; j++) {
+			for (long i=0; i<proj->nx; i++) {
+				(*lat)[j*proj->nx+i] = v[0]+j*v[2];
+				(*lon)[j*proj->nx+i] = v[1]+i*v[3];
+			}
+		}
+	} else {
+		WRFncdf geo(spec);
+		read_proj(&geo, "XLAT_M", "XLONG_M", proj);
+		*lat = read_2d(&geo, "XLAT_M");
+		*lon = read_2d(&geo, "XLONG_M");
+	}
+}
+
+/* header of static field cache <dir>/static_<key>.bin (host byte order),
+ * followed by nx*ny SOILHGT and nx*ny LANDSEA values */
+struct StaticHeader {
+	char magic[8];
+	unsigned long long key;
+	long nx, ny, nsoil;
+};
+
+/* key of static fields (signature of grid and projection) */
+unsigned long long static_key(IFFproj proj, int map_proj, size_t nsoil) {
+	float fvals[9] = {proj.dx, proj.dy, proj.startlat, proj.startlon, proj.xlonc, proj.truelat1, proj.truelat2,
+			proj.deltalat, proj.deltalon};
+	long ivals[4] = {map_proj, proj.nx, proj.ny, long(nsoil)};
+	return hash_bytes(ivals, sizeof(ivals), hash_bytes(fvals, sizeof(fvals)));
+}
+
+/* returns static field cache file name */
+string static_path(string dir, unsigned long long key) {
+	char name[40];
+	snprintf(name, sizeof(name), "static_%016llx.bin", key);
+	return dir+"/"+name;
+}
+
+/* maps static field cache (NULL if there is no valid cache for key) */
+MappedFile *load_static(string path, unsigned long long key, long nx, long ny, long nsoil) {
+	MappedFile *map = new MappedFile(path);
+	const StaticHeader *h = (const StaticHeader *) map->data();
+	if (!map->is_open() or map->size() != sizeof(StaticHeader)+2*nx*ny*sizeof(float)
+			or memcmp(h->magic, "WRFSTAT1", 8) or h->key != key
+			or h->nx != nx or h->ny != ny or h->nsoil != nsoil) {
+		delete map;
+		return NULL;
+	}
+	return map;
+}
+
+/* stores static fields in cache */
+void save_static(string path, unsigned long long key, long nx, long ny, long nsoil, void *soilhgt, void *landsea) {
+	StaticHeader h;
+	memcpy(h.magic, "WRFSTAT1", 8);
+	h.key = key;
+	h.nx = nx;
+	h.ny = ny;
+	h.nsoil = nsoil;
+	bool ok = write_atomic(path, [&](ofstream &ofile) {
+		ofile.write((const char *) &h, sizeof(h));
+		ofile.write((const char *) soilhgt, nx*ny*sizeof(float));
+		ofile.write((const char *) landsea, nx*ny*sizeof(float));
+		return true;
+	});
+	if (!ok) cout << "WARNING: Cannot write static field cache " << path << endl;
+}
+
+/* manifest entry of a completed IFF (one tab separated line in <ouput directory>/WRF2IFF.manifest) */
+struct ManifestEntry {
+	string ofile;		/* IFF name (without directory) */
+	string source;		/* full path of WRF file */
+	long long mtime;	/* modification time of WRF file when IFF was written [s] */
+	size_t source_size;	/* size of WRF file when IFF was written */
+	long t_idx;			/* time step index in WRF file */
+	unsigned long step_crc;	/* CRC-32 of time step data in WRF file (see step_crc32()) */
+	unsigned long long options;	/* key of conversion options (see options_key()) */
+	unsigned long crc;	/* CRC-32 of IFF */
+	size_t bytes;		/* size of IFF */
+};
+
+/* reads manifest (later entries of the same IFF replace earlier ones, missing manifest is empty) */
+map<string, ManifestEntry> read_manifest(string path) {
+	map<string, ManifestEntry> entries;
+	ifstream ifile(path.c_str());
+	string line;
+	while (getline(ifile, line)) {
+		if (line.empty() or line[0] == '#') continue;
+		stringstream fields(line);
+		ManifestEntry e;
+		string mtime, source_size, t_idx, step_crc, options, crc, bytes;
+		if (getline(fields, e.ofile, '\t') and getline(fields, e.source, '\t') and getline(fields, mtime, '\t') and
+				getline(fields, source_size, '\t') and getline(fields, t_idx, '\t') and getline(fields, step_crc, '\t') and
+				getline(fields, options, '\t') and getline(fields, crc, '\t') and getline(fields, bytes, '\t')) {
+			e.mtime = atoll(mtime.c_str());
+			e.source_size = strtoull(source_size.c_str(), NULL, 10);
+			e.t_idx = atol(t_idx.c_str());
+			e.step_crc = strtoul(step_crc.c_str(), NULL, 16);
+			e.options = strtoull(options.c_str(), NULL, 16);
+			e.crc = strtoul(crc.c_str(), NULL, 16);
+			e.bytes = strtoull(bytes.c_str(), NULL, 10);
+			entries[e.ofile] = e;
+		}
+	}
+	return entries;
+}
+
+/* appends entry to manifest (one write of a complete line, so concurrent runs do not mix lines) */
+void append_manifest(string path, const ManifestEntry &e) {
+	char line[PATH_MAX+128];
+	int len = snprintf(line, sizeof(line), "%s\t%s\t%lld\t%zu\t%ld\t%08lx\t%016llx\t%08lx\t%zu\n",
+			e.ofile.c_str(), e.source.c_str(), e.mtime, e.source_size, e.t_idx, e.step_crc, e.options, e.crc, e.bytes);
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd < 0 or len >= int(sizeof(line)) or write(fd, line, len) != len) {
+		cout << "WARNING: Cannot update manifest " << path << endl;
+	}
+	if (fd >= 0) close(fd);
+}
+
+/* checksum of file (false if file cannot be read) */
+bool file_crc32(string path, unsigned long *crc, size_t *bytes) {
+	MappedFile file(path);
+	if (!file.is_open()) return false;
+	*crc = calc_crc32(file.data(), file.size());
+	*bytes = file.size();
+	return true;
+}
+
+/* true if IFF of time step (cur) is recorded in manifest and unchanged since. The WRF file must
+ * be the same or have grown (not older or smaller than at conversion), the data of the time
+ * step must be unchanged (WRF files regenerated in place hold other data for the same dates)
+ * and the IFF must have been written with the same conversion options. */
+bool step_complete(const map<string, ManifestEntry> &manifest, string opath, const ManifestEntry &cur) {
+	map<string, ManifestEntry>::const_iterator it = manifest.find(cur.ofile);
+	if (it == manifest.end()) return false;
+	const ManifestEntry &e = it->second;
+	if (e.source != cur.source or e.t_idx != cur.t_idx or cur.mtime < e.mtime or cur.source_size < e.source_size
+			or cur.step_crc != e.step_crc or cur.options != e.options) return false;
+	unsigned long crc;
+	size_t bytes;
+	return file_crc32(opath+"/"+cur.ofile, &crc, &bytes) and bytes == e.bytes and crc == e.crc;
+}
+
+/* waits until time step t of followed WRF file is complete, i.e. the next time step was started,
+ * the writer closed the file or the file was not modified for idle seconds
+ * (nt is updated, false: time step t was not started before the writer closed the file or within idle seconds) */
+bool wait_step(WRFncdf *wrf, FileWatch *watch, size_t t, double idle, size_t *nt) {
+	bool waiting = false;
+	while (true) {
+		*nt = wrf->syncdimlen(wrf->dimid("Time"));
+		if (*nt > t+1) return true;
+		double quiet = difftime(time(NULL), watch->mtime());
+		if (*nt > t and (watch->closed() or quiet >= idle)) return true;
+		if (watch->closed() or quiet >= idle) return false; /* closed without time step t: nothing follows */
+		if (!waiting) {
+			cout << "Waiting for time step " << t << " of " << wrf->getname() << " ...\n";
+			waiting = true;
+		}
+		watch->wait(idle-quiet);
+	}
+}
+
+/* horizontal index window of WRF grid (ni x nj mass points from i0/j0,
+ * staggered dimensions hold one more point) */
+struct Window {
+	size_t i0, j0, ni, nj;
+};
+
+/* returns index window covering the grid points within lat0-lat1/lon0-lon1 plus one point on each side
+ * (lon0 > lon1 crosses the date line) */
+Window bbox_window(const vector<float> &lat, const vector<float> &lon, size_t nx, size_t ny,
+		float lat0, float lon0, float lat1, float lon1) {
+	size_t imin = nx, imax = 0, jmin = ny, jmax = 0;
+	for (size_t j=0; j<ny; j++) {
+		for (size_t i=0; i<nx; i++) {
+			float la = lat[j*nx+i], lo = lon[j*nx+i];
+			if (la < lat0 or la > lat1) continue;
+			if (lon0 <= lon1 ? (lo < lon0 or lo > lon1) : (lo < lon0 and lo > lon1)) continue;
+			imin = min(imin, i);
+			imax = max(imax, i);
+			jmin = min(jmin, j);
+			jmax = max(jmax, j);
+		}
+	}
+	if (imin > imax) {
+		cout << "ABORT: No grid point within bounding box " << lat0 << "," << lon0 << "," << lat1 << "," << lon1 << "!\n";
+		exit(EXIT_FAILURE);
+	}
+	Window win;
+	win.i0 = (imin > 0) ? imin-1 : 0;
+	win.j0 = (jmin > 0) ? jmin-1 : 0;
+	win.ni = min(imax+2, nx)-win.i0;
+	win.nj = min(jmax+2, ny)-win.j0;
+	return win;
+}
+
+/* key of conversion options (levels, window and grid of records, regridding and map source) */
+unsigned long long options_key(LevelCoord coord, const vector<float> &levels, const vector<float> &agl_levels,
+		const Window &win, IFFproj oproj, string regrid, RegridMethod method, string mapsource) {
+	float fvals[9] = {oproj.dx, oproj.dy, oproj.startlat, oproj.startlon, oproj.xlonc, oproj.truelat1, oproj.truelat2,
+			oproj.deltalat, oproj.deltalon};
+	long ivals[11] = {coord, long(levels.size()), long(agl_levels.size()), long(win.i0), long(win.j0), long(win.ni),
+			long(win.nj), oproj.iproj, oproj.nx, oproj.ny, method};
+	unsigned long long h = hash_bytes(ivals, sizeof(ivals), hash_bytes(fvals, sizeof(fvals)));
+	h = hash_bytes(levels.data(), levels.size()*sizeof(float), h);
+	h = hash_bytes(agl_levels.data(), agl_levels.size()*sizeof(float), h);
+	h = hash_bytes(regrid.data(), regrid.size(), h);
+	return hash_bytes(mapsource.data(), mapsource.size(), h);
+}
+
+/* reads slab of time step t of variable within window (buffer is taken from pool set in wrf,
+ * variables without Time dimension are read for all times) */
+void *read_step(WRFncdf *wrf, string vname, size_t t, const Window &win) {
+	int type, ndims = wrf->varndims(vname);
+	size_t *dims = wrf->vardims(vname);
+	size_t start[ndims], count[ndims];
+
+	for (int d=0; d<ndims; d++) {
+		string dname = wrf->dimname(dims[d]);
+		start[d] = 0;
+		count[d] = wrf->dimlen(dims[d]);
+		if (dname == "Time") {
+			start[d] = t;
+			count[d] = 1;
+		} else if (dname == "west_east" or dname == "west_east_stag") {
+			start[d] = win.i0;
+			count[d] = win.ni+(dname == "west_east_stag");
+		} else if (dname == "south_north" or dname == "south_north_stag") {
+			start[d] = win.j0;
+			count[d] = win.nj+(dname == "south_north_stag");
+		}
+	}
+	return wrf->vardata(vname, &type, &ndims, start, count);
+}
+
+/* CRC-32 of time step t of WRF file within window (Times string, T2 and PSFC slabs), identifies
+ * the data of the time step cheaply (e.g. a rerun simulation writes other values for the same dates) */
+unsigned long step_crc32(WRFncdf *wrf, void *Time, size_t t, const Window &win) {
+	size_t n = win.ni*win.nj*sizeof(float);
+	unsigned long crc = calc_crc32(Time, 19);
+	crc = calc_crc32(read_step(wrf, "T2", t, win), n, crc);
+	return calc_crc32(read_step(wrf, "PSFC", t, win), n, crc);
 }
 
 int main(int argc, char** argv) {
 	size_t nx, ny, nt, nsoil;
-	size_t start2D[3] = {0,0,0};
-	size_t count2D[3] = {1,1,1};
 	string ifilename, opath;
 	void *Time, *t2k, *u10, *v10, *u, *v, *w, *w10, *psfc, *q2, *rh2, *zs, *smois, *st, *seaice, *isltyp,
-		 *soilhgt, *skintemp, *snow, *snowh, *sst, *ph, *phb, *ght_stag, *ght_unstag, *u_unstag, *v_unstag, *w_unstag, *landsea,
-		 *sm000010, *sm010040, *sm040100, *sm100200, *st000010, *st010040, *st040100, *st100200;
+		 *soilhgt, *skintemp, *snow, *snowh, *sst, *ph, *phb, *ght_stag, *ght_unstag, *u_unstag, *v_unstag, *w_unstag, *landsea;
+	BufferPool &pool = buffer_pool(); /* per time step buffers (reset after each time step) */
 	IFFproj proj;
-	int dummy;
 	string mapsource = string("WRF SVLPP D07 V1");/* your own identifier to be set in IFF
 												   * EXAMPLE:        "WRF SVLPP D07 V1"
 												   *				  ^   ^     ^   ^
@@ -44,13 +482,84 @@ int main(int argc, char** argv) {
 	/*************************************
 	 * check and extract given arguments *
 	 *************************************/
-	if (argc < 3) {
+	vector<float> agl_levels; /* additional wind levels above ground [m] */
+	string cachedir; /* static field cache */
+	bool resume = false; /* skip time steps completed before */
+	bool follow = false; /* wait for time steps appended to WRF file */
+	string regrid; /* target grid of regridding (empty: records on WRF grid) */
+	vector<double> crop; /* index window i0,j0,ni,nj or bounding box lat0,lon0,lat1,lon1 (empty: whole grid) */
+	bool crop_bbox = false;
+	RegridMethod regrid_method = REGRID_BILINEAR;
+	double follow_idle = 3600.0; /* end of following if WRF file is not modified [s] */
+	LevelCoord coord; /* output levels of 3D fields */
+	vector<float> levels;
+	parse_levels("pressure", &coord, &levels);
+	for (int a=1; a<argc; a++) {
+		string arg = string(argv[a]);
+		if (!arg.compare(0,strlen("--levels="),"--levels=")) {
+			parse_levels(arg.substr(strlen("--levels=")), &coord, &levels);
+		} else if (!arg.compare(0,strlen("--cache="),"--cache=")) {
+			cachedir = arg.substr(strlen("--cache="));
+		} else if (arg == "--follow" or !arg.compare(0,strlen("--follow="),"--follow=")) {
+			follow = true;
+			if (arg != "--follow") follow_idle = atof(arg.substr(strlen("--follow=")).c_str());
+			if (follow_idle <= 0) {
+				cout << "ABORT: Idle time " << arg.substr(strlen("--follow=")) << " not supported (> 0 s)!\n";
+				return EXIT_FAILURE;
+			}
+		} else if (!arg.compare(0,strlen("--regrid="),"--regrid=")) {
+			regrid = arg.substr(strlen("--regrid="));
+		} else if (!arg.compare(0,strlen("--regrid-method="),"--regrid-method=")) {
+			string m = arg.substr(strlen("--regrid-method="));
+			if (m == "bilinear") regrid_method = REGRID_BILINEAR;
+			else if (m == "conservative") regrid_method = REGRID_CONSERVATIVE;
+			else {
+				cout << "ABORT: Regridding method " << m << " not supported!\n";
+				return EXIT_FAILURE;
+			}
+		} else if (!arg.compare(0,strlen("--window="),"--window=") or !arg.compare(0,strlen("--bbox="),"--bbox=")) {
+			bool is_bbox = !arg.compare(0,strlen("--bbox="),"--bbox=");
+			stringstream list(arg.substr(arg.find('=')+1));
+			string item;
+			crop.clear();
+			while (getline(list, item, ',')) crop.push_back(atof(item.c_str()));
+			if (crop.size() != 4 or (is_bbox and crop[0] > crop[2]) or (!is_bbox and (crop[0] < 0 or crop[1] < 0 or crop[2] < 1 or crop[3] < 1))) {
+				cout << "ABORT: " << arg << " not supported!\n";
+				return EXIT_FAILURE;
+			}
+			crop_bbox = is_bbox;
+		} else if (arg == "--resume") {
+			resume = true;
+		} else if (!arg.compare(0,strlen("--agl="),"--agl=")) {
+			stringstream list(arg.substr(strlen("--agl=")));
+			string item;
+			while (getline(list, item, ',')) {
+				float h = atof(item.c_str());
+				if (h <= 0 or h >= 1000) {
+					cout << "ABORT: Height above ground " << item << " not supported (0 < h < 1000 m)!\n";
+					return EXIT_FAILURE;
+				}
+				agl_levels.push_back(h);
+			}
+		} else if (!arg.compare(0,2,"--")) {
+			cout << "ABORT: Unknown option " << arg << "!\n";
+			print_help();
+			return EXIT_FAILURE;
+		} else if (ifilename.empty()) {
+			ifilename = arg; /* extract input filename */
+		} else if (opath.empty()) {
+			opath = arg; /* extract output path */
+		}
+	}
+	if (ifilename.empty() or opath.empty()) {
 		print_help();
 		return EXIT_FAILURE;
-	} else {
-		ifilename = string(argv[1]); /* extract input filename */
-		opath = string(argv[2]); /* extract output path */
 	}
+	long n_agl = agl_levels.size();
+
+	/* W is interpolated to 10 m and the additional levels */
+	vector<float> agl_w(1, 10.0);
+	agl_w.insert(agl_w.end(), agl_levels.begin(), agl_levels.end());
 
 	/*************
 	 * Open file *
@@ -89,6 +598,18 @@ int main(int argc, char** argv) {
 	wrf.check_memorder("P", "UNSTAG");
 	wrf.check_memorder("PB", "UNSTAG");
 
+	/* followed WRF file is watched from now on (modifications after opening are caught by the first check),
+	 * time invariant fields are read from the first time step, so it has to be complete before */
+	FileWatch *watch = NULL;
+	if (follow) {
+		watch = new FileWatch(ifilename);
+		if (!wait_step(&wrf, watch, 0, follow_idle, &nt)) {
+			cout << "No time step written to " << ifilename << ", nothing to convert.\n";
+			delete watch;
+			return EXIT_SUCCESS;
+		}
+	}
+
 	/****************************************
 	 * load required dimension informations *
 	 ****************************************/
@@ -99,61 +620,238 @@ int main(int argc, char** argv) {
 	size_t n_sns = wrf.dimlen(wrf.dimid("south_north_stag")); // length of staggered south north dimension
 	size_t n_snu = wrf.dimlen(wrf.dimid("south_north")); // length of staggered south north dimension
 
+	/* index window of converted grid points (only the window is read and processed) */
+	Window win = {0, 0, n_weu, n_snu};
+	if (crop_bbox) {
+		win = bbox_window(read_2d(&wrf, "XLAT"), read_2d(&wrf, "XLONG"), n_weu, n_snu, crop[0], crop[1], crop[2], crop[3]);
+	} else if (!crop.empty()) {
+		win.i0 = crop[0];
+		win.j0 = crop[1];
+		win.ni = crop[2];
+		win.nj = crop[3];
+		if (win.i0+win.ni > n_weu or win.j0+win.nj > n_snu) {
+			cout << "ABORT: Window " << win.i0 << "," << win.j0 << "," << win.ni << "," << win.nj
+					<< " exceeds WRF grid of " << n_weu << "x" << n_snu << " points!\n";
+			return EXIT_FAILURE;
+		}
+	}
+	n_weu = win.ni;
+	n_wes = win.ni+1;
+	n_snu = win.nj;
+	n_sns = win.nj+1;
+
 	/********************************
 	 * load projection informations *
 	 ********************************/
-	if (wrf.gattval(wrf.gattid("MAP_PROJ")).i == 2) proj.iproj = 5;
-	else {
-		cout << "ABORT: Projection " << wrf.gattval(wrf.gattid("MAP_PROJ")).i << " not supported!\n";
-		return EXIT_FAILURE;
-	}
-	proj.dx = wrf.gattval(wrf.gattid("DX")).f;
-	proj.dy = wrf.gattval(wrf.gattid("DY")).f;
-	cp_string(proj.startloc, 9, "SWCORNER", strlen("SWCORNER"));
-	proj.startlat = ((float *)wrf.vardataraw("XLAT"))[0];
-	proj.startlon = ((float *)wrf.vardataraw("XLONG"))[0];
-	proj.xlonc = wrf.gattval(wrf.gattid("STAND_LON")).f;
-	proj.truelat1 = wrf.gattval(wrf.gattid("TRUELAT1")).f;
-	proj.earth_radius = 6371220.0;
+	read_proj(&wrf, "XLAT", "XLONG", &proj);
 	nx = n_weu;
 	ny = n_snu;
-	proj.nx = nx;
-	proj.ny = ny;
+	if (nx != size_t(proj.nx) or ny != size_t(proj.ny)) {
+		/* start location is south west corner of window */
+		size_t start_sw[3] = {0,win.j0,win.i0}, count_sw[3] = {1,1,1};
+		wrf.vardata("XLAT", start_sw, count_sw, &proj.startlat);
+		wrf.vardata("XLONG", start_sw, count_sw, &proj.startlon);
+		proj.nx = nx;
+		proj.ny = ny;
+		cout << "WINDOW = " << win.i0 << "," << win.j0 << "," << win.ni << "," << win.nj << endl;
+	}
 
 	/**********************
 	 * load time variable *
 	 **********************/
 	nt = wrf.dimlen(wrf.dimid("Time"));
-	Time = wrf.vardataraw("Times");
-
-	/***********************
-	 * unstagger variables *
-	 ***********************/
-	/* load required variables */
-	ph = wrf.vardataraw("PH");
-	phb = wrf.vardataraw("PHB");
-	u = wrf.vardataraw("U");
-	v = wrf.vardataraw("V");
-	w = wrf.vardataraw("W");
-
-	/* allocate memory for unstaggered variables */
-	ght_stag = malloc(sizeof(float)*nt*n_bts*ny*nx);
-	ght_unstag = malloc(sizeof(float)*nt*n_btu*ny*nx);
-	u_unstag = malloc(sizeof(float)*nt*n_btu*ny*nx);
-	v_unstag = malloc(sizeof(float)*nt*n_btu*ny*nx);
-	w_unstag = malloc(sizeof(float)*nt*n_btu*ny*nx);
-
-	/* unstagger */
-	for (long i=0; i<nt; i++) { // time dimension loop
+
+	/*************************************
+	 * load time invariant surface fields *
+	 *************************************/
+	/* fields of the same domain are mapped from the static field cache if available */
+	nsoil = wrf.dimlen(wrf.dimid("soil_layers_stag"));
+	unsigned long long skey = static_key(proj, wrf.gattval(wrf.gattid("MAP_PROJ")).i, nsoil);
+	MappedFile *static_map = cachedir.empty() ? NULL : load_static(static_path(cachedir, skey), skey, nx, ny, nsoil);
+	if (static_map) {
+		cout << "Static fields mapped from " << static_path(cachedir, skey) << endl;
+		soilhgt = (void *) &((const StaticHeader *) static_map->data())[1];
+		landsea = (void *) &((const float *) soilhgt)[nx*ny];
+	} else {
+	/* first time step of fields not changing with time (e.g. soilhgt) */
+	soilhgt = read_step(&wrf, "HGT", 0, win);	// SOILHGT	m		200100.
+	isltyp = read_step(&wrf, "ISLTYP", 0, win);
+
+	/* check number and depth of soil layers */
+	zs = wrf.vardataraw("ZS");
+	if (nsoil != 4) {
+		cout << "ABORT: " << nsoil << " soil layers not supported!\n";
+		exit(EXIT_FAILURE);
+	} else {
+		if ((fabs(((float*)zs)[0] - 0.05) > 0.001) ||
+			(fabs(((float*)zs)[1] - 0.25) > 0.001) ||
+			(fabs(((float*)zs)[2] - 0.7)  > 0.001) ||
+			(fabs(((float*)zs)[3] - 1.5)  > 0.001)) {
+			cout << "ABORT: Depth structure [ ";
+			for (size_t i=0; i<nsoil ; i++) cout << ((float*)zs)[i] << " ";
+			cout << "] of soil layers not supported!\n";
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* extract land sea flag */
+	landsea = malloc(sizeof(float)*ny*nx);
+	for (size_t idx_sfc=0; idx_sfc<ny*nx; idx_sfc++) {
+		if (((((int*) isltyp)[idx_sfc]) == 14) ||
+			((((int*) isltyp)[idx_sfc]) == 16)) // a bit hacky (seems that 16 is not always sea ice)
+				((float *) landsea)[idx_sfc] = 0.0; // land sea flag		proprtn		200100.
+		else	((float *) landsea)[idx_sfc] = 1.0;
+	}
+	if (!cachedir.empty()) save_static(static_path(cachedir, skey), skey, nx, ny, nsoil, soilhgt, landsea);
+	}
+
+	/* set output level variables */
+	if (coord == LEVELS_NATIVE) {
+		if (levels.empty()) for (size_t l=1; l<=n_btu; l++) levels.push_back(l);
+		for (size_t l=0; l<levels.size(); l++) {
+			if (levels[l] != floor(levels[l]) or levels[l] < 1 or levels[l] > n_btu) {
+				cout << "ABORT: Model level " << levels[l] << " not available (1-" << n_btu << ")!\n";
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	long n_lvl = levels.size();
+
+	/********************
+	 * print short info *
+	 ********************/
+	cout << "MAP_PROJ = " << proj.iproj << endl;
+	cout << "DX = " << proj.dx << ", DY = " << proj.dy << endl;
+	cout << "STARTLOC = " << proj.startloc << endl;
+	cout << "STARTLAT = " << proj.startlat << ", STARTLON = " << proj.startlon << endl;
+	cout << "STAND_LON = " << proj.xlonc << ", TRUELAT1 = " << proj.truelat1 << endl;
+	if (proj.iproj == 3) cout << "TRUELAT2 = " << proj.truelat2 << endl;
+	if (proj.iproj == 0) cout << "DELTALAT = " << proj.deltalat << ", DELTALON = " << proj.deltalon << endl;
+	cout << "EARTH_RADIUS = " << proj.earth_radius << endl;
+	cout << "NT = " << nt << ", NX = " << proj.nx << ", NY = " << proj.ny << ", NSOIL = " << nsoil << endl;
+
+	/************************************************
+	 * set up regridding to target grid if required *
+	 ************************************************/
+	IFFproj oproj = proj; /* projection of records */
+	SparseMatrix *weights = NULL; /* target = weights * WRF grid */
+	void *soilhgt_out = soilhgt, *landsea_out = landsea;
+	if (!regrid.empty()) {
+		vector<float> tlat, tlon;
+		read_target(regrid, &oproj, &tlat, &tlon);
+		/* winds stay grid relative, so they keep their direction only on a target of the same projection
+		 * (winds of lat/lon and Mercator grids are earth relative) */
+		if ((proj.iproj == 3 or proj.iproj == 5) and (oproj.iproj != proj.iproj or oproj.xlonc != proj.xlonc or
+				oproj.truelat1 != proj.truelat1 or (proj.iproj == 3 and oproj.truelat2 != proj.truelat2))) {
+			cout << "ABORT: Projection of target grid " << regrid << " differs from WRF grid (MAP_PROJ = " << proj.iproj
+					<< "), grid relative winds would be wrong!\n";
+			return EXIT_FAILURE;
+		}
+		float *lat = (float *) read_step(&wrf, "XLAT", 0, win), *lon = (float *) read_step(&wrf, "XLONG", 0, win);
+		GridIndex src(nx, ny, lat, lon, cachedir);
+		free(lat);
+		free(lon);
+
+		/* target grid has to be within WRF domain (checked at its boundary) */
+		GridWeights gw;
+		for (long j=0; j<oproj.ny; j++) {
+			for (long i=0; i<oproj.nx; i++) {
+				if (j > 0 and j < oproj.ny-1 and i > 0 and i < oproj.nx-1) i = oproj.nx-1;
+				if (!src.bilinear(tlat[j*oproj.nx+i], tlon[j*oproj.nx+i], &gw)) {
+					cout << "ABORT: Target grid point " << i << "," << j << " (" << tlat[j*oproj.nx+i] << ", "
+							<< tlon[j*oproj.nx+i] << ") outside of WRF domain!\n";
+					return EXIT_FAILURE;
+				}
+			}
+		}
+		weights = new SparseMatrix(regrid_weights(src, oproj.nx, oproj.ny, &tlat[0], &tlon[0], regrid_method, cachedir));
+		cout << "Regridding to " << regrid << " (" << (regrid_method == REGRID_BILINEAR ? "bilinear" : "conservative")
+				<< "): MAP_PROJ = " << oproj.iproj << ", NX = " << oproj.nx << ", NY = " << oproj.ny
+				<< ", " << weights->nnz() << " weights\n";
+
+		/* time invariant fields are regridded once (land sea flag stays a flag) */
+		soilhgt_out = malloc(sizeof(float)*oproj.nx*oproj.ny);
+		landsea_out = malloc(sizeof(float)*oproj.nx*oproj.ny);
+		weights->apply((float *) soilhgt, (float *) soilhgt_out);
+		weights->apply((float *) landsea, (float *) landsea_out);
+		for (long idx=0; idx<oproj.nx*oproj.ny; idx++) ((float *) landsea_out)[idx] = (((float *) landsea_out)[idx] >= 0.5) ? 1.0 : 0.0;
+	}
+	long n_out = oproj.nx*oproj.ny; /* number of values per record */
+
+	/* regrids nlev levels of field to target grid (field itself without regridding) */
+	auto regrid_levels = [&](void *field, long nlev) -> void * {
+		if (!weights or !field) return field;
+		float *out = (float *) pool.acquire(sizeof(float)*nlev*n_out);
+		for (long l=0; l<nlev; l++) weights->apply(&((float *) field)[l*ny*nx], &out[l*n_out]);
+		return out;
+	};
+
+	/*****************************************************************
+	 * process time steps (all time dependent variables are read and *
+	 * calculated for one time step, buffers are reused by the pool) *
+	 *****************************************************************/
+	/* completed time steps (incremental conversion) */
+	string manifest_path = opath+"/WRF2IFF.manifest";
+	map<string, ManifestEntry> manifest;
+	char source[PATH_MAX];
+	struct stat source_stat;
+	if (!realpath(ifilename.c_str(), source) or stat(source, &source_stat)) {
+		cout << "ABORT: Cannot stat " << ifilename << "!\n";
+		return EXIT_FAILURE;
+	}
+	unsigned long long options = options_key(coord, levels, agl_levels, win, oproj, regrid, regrid_method, mapsource);
+	if (resume) manifest = read_manifest(manifest_path);
+
+	wrf.setpool(&pool);
+	for (long i=0; follow ? wait_step(&wrf, watch, i, follow_idle, &nt) : size_t(i)<nt; i++) {
+		Time = read_step(&wrf, "Times", i, win);
+
+		/* one IFF for each time step (Time and all records hold current time step only) */
+		string oname = string("WRF:")+time2str(Time,0);
+		string ofilename = opath+"/"+oname;
+		ManifestEntry step; /* manifest entry of time step */
+		if (resume) {
+			if (stat(source, &source_stat)) {
+				cout << "ABORT: Cannot stat " << source << "!\n";
+				return EXIT_FAILURE;
+			}
+			step.ofile = oname;
+			step.source = source;
+			step.mtime = source_stat.st_mtime;
+			step.source_size = source_stat.st_size;
+			step.t_idx = i;
+			step.step_crc = step_crc32(&wrf, Time, i, win);
+			step.options = options;
+		}
+		if (resume and step_complete(manifest, opath, step)) {
+			cout << "Skipping " << ofilename << " (complete)\n";
+			pool.reset();
+			continue;
+		}
+
+		/***********************
+		 * unstagger variables *
+		 ***********************/
+		/* load required variables */
+		ph = read_step(&wrf, "PH", i, win);
+		phb = read_step(&wrf, "PHB", i, win);
+		u = read_step(&wrf, "U", i, win);
+		v = read_step(&wrf, "V", i, win);
+		w = read_step(&wrf, "W", i, win);
+
+		/* allocate memory for unstaggered variables */
+		ght_stag = pool.acquire(sizeof(float)*n_bts*ny*nx);
+		ght_unstag = pool.acquire(sizeof(float)*n_btu*ny*nx);
+		u_unstag = pool.acquire(sizeof(float)*n_btu*ny*nx);
+		v_unstag = pool.acquire(sizeof(float)*n_btu*ny*nx);
+		w_unstag = pool.acquire(sizeof(float)*n_btu*ny*nx);
+
+		/* unstagger */
 		for (long j=0; j<n_btu; j++) { // unstaggered bottom top dimension loop
 			for (long k=0; k<n_snu; k++)  { // unstaggered south_north dimension loop
 				for (long l=0; l<n_weu; l++)  { // unstaggered west_east dimension loop
 
 					/* dimension slice indices */
-					long t_bts = i*n_bts*n_snu*n_weu;	//(1D) time slice in bottom top staggered grid
-					long t_sns = i*n_btu*n_sns*n_weu;	//(1D) time slice in south north staggered grid
-					long t_wes = i*n_btu*n_snu*n_wes;	//(1D) time slice in west east staggered grid
-					long t_btu = i*n_btu*n_snu*n_weu;	//(1D) time slice in unstaggered grid
 					long z_sns = j*n_sns*n_weu;			//(2D) bottom top slice in south north staggered grid
 					long z_wes = j*n_snu*n_wes;			//(2D) bottom top slice in west east staggered grid
 					long z_lo = j*n_snu*n_weu;			//(2D) bottom top slice in unstaggered grid
@@ -164,13 +862,13 @@ int main(int argc, char** argv) {
 					long y_btu = k*n_weu;				//(3D) north south slice in unstaggered grid
 
 					/* interpolation indices */
-					long idx_unstag = t_btu+z_lo+y_btu+l;		//current index in unstaggered grid
-					long idx_stag_lo = t_bts+z_lo+y_btu+l;		//current lower index in bottom top staggered grid
-					long idx_stag_up = t_bts+z_up+y_btu+l;		//current upper index in bottom top staggered grid
-					long idx_left = t_wes+z_wes+y_wes+l;		//current western index in west east staggered grid
-					long idx_right = t_wes+z_wes+y_wes+l+1;		//current eastern index in west east staggered grid
-					long idx_below = t_sns+z_sns+y_sns_below+l;	//current southern index in south north staggered grid
-					long idx_above = t_sns+z_sns+y_sns_above+l;	//current northern index in south north staggered grid
+					long idx_unstag = z_lo+y_btu+l;		//current index in unstaggered grid
+					long idx_stag_lo = z_lo+y_btu+l;		//current lower index in bottom top staggered grid
+					long idx_stag_up = z_up+y_btu+l;		//current upper index in bottom top staggered grid
+					long idx_left = z_wes+y_wes+l;		//current western index in west east staggered grid
+					long idx_right = z_wes+y_wes+l+1;		//current eastern index in west east staggered grid
+					long idx_below = z_sns+y_sns_below+l;	//current southern index in south north staggered grid
+					long idx_above = z_sns+y_sns_above+l;	//current northern index in south north staggered grid
 
 					/* temporal loop values */
 					float ph_lo  = ((float *) ph)[idx_stag_lo];	//perturbation pressure at lower level
@@ -198,448 +896,457 @@ int main(int argc, char** argv) {
 				}
 			}
 		}
-	}
-
-	/**************************
-	 * load surface variables *
-	 **************************/
-	t2k = wrf.vardataraw("T2");			// TT		K		200100.
-	u10 = wrf.vardataraw("U10");		// UU		m s-1 	200100.
-	v10 = wrf.vardataraw("V10");		// VV		m s-1	200100.
-	psfc = wrf.vardataraw("PSFC");		// PSFC		Pa		200100.
-	seaice = wrf.vardataraw("SEAICE"); 	// SEAICE	proprtn	200100.
-	/*prepare count vector for extracting first 2D slice from a data
-	 * set, e.g. soilhgt is not changing with time... */
-	count2D[1] = ny;
-	count2D[2] = nx;
-	if (wrf.varndims("HGT") == 2) soilhgt = wrf.vardataraw("HGT");	// SOILHGT	m		200100.
-	else soilhgt = wrf.vardata("HGT", &dummy, &dummy, start2D, count2D);
-	skintemp = wrf.vardataraw("TSK");	// SKINTMP	K		200100.
-//	snow = wrf.vardataraw("SNOW");		// SNOW		kg m-2	200100.
-//	snowh = wrf.vardataraw("SNOWH");	// SNOWH	m		200100.
-	sst = wrf.vardataraw("SST");		// SST		K		200100.
 
-	/* check number and depth of soil layers */
-	zs = wrf.vardataraw("ZS");
-	nsoil = wrf.dimlen(wrf.dimid("soil_layers_stag"));
-	if (nsoil != 4) {
-		cout << "ABORT: " << nsoil << " soil layers not supported!\n";
-		exit(EXIT_FAILURE);
-	} else {
-		if ((fabs(((float*)zs)[0] - 0.05) > 0.001) ||
-			(fabs(((float*)zs)[1] - 0.25) > 0.001) ||
-			(fabs(((float*)zs)[2] - 0.7)  > 0.001) ||
-			(fabs(((float*)zs)[3] - 1.5)  > 0.001)) {
-			cout << "ABORT: Depth structure [ ";
-			for (int i=0; i<nsoil ; i++) cout << ((float*)zs)[i] << " ";
-			cout << "] of soil layers not supported!\n";
-			exit(EXIT_FAILURE);
+		/**************************
+		 * load surface variables *
+		 **************************/
+		t2k = read_step(&wrf, "T2", i, win);			// TT		K		200100.
+		u10 = read_step(&wrf, "U10", i, win);		// UU		m s-1 	200100.
+		v10 = read_step(&wrf, "V10", i, win);		// VV		m s-1	200100.
+		psfc = read_step(&wrf, "PSFC", i, win);		// PSFC		Pa		200100.
+		seaice = read_step(&wrf, "SEAICE", i, win); 	// SEAICE	proprtn	200100.
+		skintemp = read_step(&wrf, "TSK", i, win);	// SKINTMP	K		200100.
+//		snow = read_step(&wrf, "SNOW", i, win);		// SNOW		kg m-2	200100.
+//		snowh = read_step(&wrf, "SNOWH", i, win);	// SNOWH	m		200100.
+		sst = read_step(&wrf, "SST", i, win);		// SST		K		200100.
+
+		/***************************************
+		 * calculate missing surface variables *
+		 ***************************************/
+		/* load required variables */
+		q2 = read_step(&wrf, "Q2", i, win);
+
+		/* soil moisture/temperature slabs (soil layers are written directly from the slabs) */
+		smois = read_step(&wrf, "SMOIS", i, win);	// SM000010 ... SM100200	fraction	200100.
+		st = read_step(&wrf, "TSLB", i, win);		// ST000010 ... ST100200	K			200100.
+		auto soil_layer = [&](void *slab, long l) { // view on soil layer l of slab (on record grid)
+			return FieldSpan<const float>(&((const float *) slab)[l*n_out], n_out);
+		};
+
+		/* allocate memory for missing variables surface */
+		rh2 = pool.acquire(sizeof(float)*ny*nx);
+		w10 = pool.acquire(sizeof(float)*ny*nx);
+		float *uu_agl = NULL, *vv_agl = NULL, *ww_agl = NULL;
+		if (n_agl > 0) {
+			uu_agl = (float *) pool.acquire(sizeof(float)*n_agl*ny*nx);
+			vv_agl = (float *) pool.acquire(sizeof(float)*n_agl*ny*nx);
+			ww_agl = (float *) pool.acquire(sizeof(float)*n_agl*ny*nx);
 		}
-	}
 
-	/***************************************
-	 * calculate missing surface variables *
-	 ***************************************/
-	/* load required variables */
-	q2 = wrf.vardataraw("Q2");
-	if (wrf.varndims("ISLTYP") == 2) isltyp = wrf.vardataraw("ISLTYP");
-	else isltyp = wrf.vardata("ISLTYP", &dummy, &dummy, start2D, count2D);
-	smois = wrf.vardataraw("SMOIS");
-	st = wrf.vardataraw("TSLB");
-
-	/* allocate memory for missing variables surface */
-	rh2 = malloc(sizeof(float)*nt*ny*nx);
-	landsea = malloc(sizeof(float)*nt*ny*nx);
-	w10 = malloc(sizeof(float)*nt*ny*nx);
-	sm000010 = malloc(sizeof(float)*nt*ny*nx);
-	sm010040 = malloc(sizeof(float)*nt*ny*nx);
-	sm040100 = malloc(sizeof(float)*nt*ny*nx);
-	sm100200 = malloc(sizeof(float)*nt*ny*nx);
-	st000010 = malloc(sizeof(float)*nt*ny*nx);
-	st010040 = malloc(sizeof(float)*nt*ny*nx);
-	st040100 = malloc(sizeof(float)*nt*ny*nx);
-	st100200 = malloc(sizeof(float)*nt*ny*nx);
-
-	/* calculate missing variables */
-	for (long i=0; i<nt; i++) { // time dimension loop
+		/* calculate missing variables */
 		for (long j=0; j<ny; j++) { // south_north dimension loop
 			for (long k=0; k<nx; k++) { // west_east dimension loop
 
 				/* dimension slice indices */
-				long idx_sfc = (j*nx)+k; //current index in timeless surface grid
-				long idx_cur = (i*ny*nx)+idx_sfc; // current index in surface grid
-				long idx_sl0 = (i*n_bts*ny*nx)+(0*ny*nx)+idx_sfc; //current index in first level of soil layer gird
-				long idx_sl1 = (i*n_bts*ny*nx)+(1*ny*nx)+idx_sfc; //current index in second level of soil layer gird
-				long idx_sl2 = (i*n_bts*ny*nx)+(2*ny*nx)+idx_sfc; //current index in third level of soil layer gird
-				long idx_sl3 = (i*n_bts*ny*nx)+(3*ny*nx)+idx_sfc; //current index in forth level of soil layer gird
+				long idx_sfc = (j*nx)+k; //current index in surface grid
 
 				/* calculate relative humidity at 2m */
-				((float *) rh2)[idx_cur] = // RH		%		200100.
-						calc_rh(((float*)  q2)[idx_cur], // water vapor mixing ratio [kg/kg]
-									((float*) psfc)[idx_cur], // surface pressure [Pa]
-									((float*)  t2k)[idx_cur]);// 2m temperature [K]
-
-				/* extract land sea flag */
-				if (((((int*) isltyp)[idx_sfc]) == 14) ||
-					((((int*) isltyp)[idx_sfc]) == 16)) // a bit hacky (seems that 16 is not always sea ice)
-						((float *) landsea)[idx_cur] = 0.0; // land sea flag		proprtn		200100.
-				else	((float *) landsea)[idx_cur] = 1.0;
-
-				/* calculate vertical wind at 10m
-				(find height interval in staggered grid for interpolation) */
-				long n_lo = 0;
-				long n_up = 0;
-				float p_cur;
-				for (long l_cur=1; l_cur<n_bts; l_cur++) {
-					long idx_cur = i*(n_bts*ny*nx)+l_cur*(ny*nx)+idx_sfc; //current index in staggered grid
-					float l_height = ((float*) ght_stag)[idx_cur]-((float *) soilhgt)[idx_sfc];
-					n_lo = n_up;
-					n_up = l_cur;
-					if ((l_height - 10) > 0) {
-						break;
-					}
-				}
-
-				/* interpolation indices */
-				long idx_lo = (i*n_bts*ny*nx)+(n_lo*ny*nx)+idx_sfc; // current of lower level index in unstaggered grid
-				long idx_up = (i*n_bts*ny*nx)+(n_up*ny*nx)+idx_sfc; // current of upper level index in unstaggered grid
-
-				/* temporal loop values */
-				float w_lo = ((float*) w)[idx_lo]; //lower level w wind vector [m s-1]
-				float w_up = ((float*) w)[idx_up]; //upper level w wind vector [m s-1]
-				float ght_lo = ((float*) ght_stag)[idx_lo] - ((float *) soilhgt)[idx_sfc]; //lower level height [m a.g.]
-				float ght_up = ((float*) ght_stag)[idx_up] - ((float *) soilhgt)[idx_sfc]; //upper level height [m a.g.]
-
-				/* interpolate w wind vector at 10 m level from upper and lower level values */
-				((float *) w10)[idx_cur] = // W10		m s-1	200100.
-						interpol(w_lo, w_up, ght_lo, ght_up, 10.0);
-
-				/* extract soil moisture fields*/
-				((float *) sm000010)[idx_cur] = // SM000010		fraction	200100. (Soil Moisture 0-10 cm below ground layer (Upper))
-						((float *) smois)[idx_sl0];
-				((float *) sm010040)[idx_cur] = // SM010040		fraction	200100. (Soil Moisture 10-40 cm below ground layer (Upper))
-						((float *) smois)[idx_sl1];
-				((float *) sm040100)[idx_cur] = // SM040100		fraction	200100. (Soil Moisture 40-100 cm below ground layer (Upper))
-						((float *) smois)[idx_sl2];
-				((float *) sm100200)[idx_cur] = // SM100200		fraction	200100. (Soil Moisture 100-200 cm below ground layer (Bottom))
-						((float *) smois)[idx_sl3];
-
-				/* extract soil temperature fields*/
-				((float *) st000010)[idx_cur] = // ST000010		K		200100. (T 0-10 cm below ground layer (Upper))
-						((float *) st)[idx_sl0];
-				((float *) st010040)[idx_cur] = // ST010040		K		200100. (T 10-40 cm below ground layer (Upper))
-						((float *) st)[idx_sl1];
-				((float *) st040100)[idx_cur] = // ST040100		K		200100. (T 40-100 cm below ground layer (Upper))
-						((float *) st)[idx_sl2];
-				((float *) st100200)[idx_cur] = // ST100200		K		200100. (T 100-200 cm below ground layer (Bottom))
-						((float *) st)[idx_sl3];
+				((float *) rh2)[idx_sfc] = // RH		%		200100.
+						calc_rh(((float*)  q2)[idx_sfc], // water vapor mixing ratio [kg/kg]
+									((float*) psfc)[idx_sfc], // surface pressure [Pa]
+									((float*)  t2k)[idx_sfc]);// 2m temperature [K]
 			}
 		}
-	}
-
-	/**************************************
-	 * calculate pressure level variables *
-	 **************************************/
-	/* set output pressure level variables */
-	long n_plv = 26;
-	float plvl[26] = {100000.0, 97500.0, 95000.0, 92500.0, 90000.0, 85000.0, 80000.0, 75000.0, 70000.0, 65000.0, 60000.0, 55000.0, 50000.0,
-			45000.0, 40000.0, 35000.0, 30000.0, 25000.0, 20000.0, 15000.0, 10000.0, 7000.0, 5000.0, 3000.0, 2000.0, 1000.0}; // output pressure levels
-
-	/* load required variables */
-	void *p = wrf.vardataraw("P");
-	void *pb = wrf.vardataraw("PB");
-	void *t = wrf.vardataraw("T");
-	void *qvapor = wrf.vardataraw("QVAPOR");
-
-	/* allocate memory for pressure level variables */
-	void *tt_press = malloc(sizeof(float)*nt*n_plv*ny*nx);
-	void *rh_press = malloc(sizeof(float)*nt*n_plv*ny*nx);
-	void *uu_press = malloc(sizeof(float)*nt*n_plv*ny*nx);
-	void *vv_press = malloc(sizeof(float)*nt*n_plv*ny*nx);
-	void *ww_press = malloc(sizeof(float)*nt*n_plv*ny*nx);
-	void *ght_press = malloc(sizeof(float)*nt*n_plv*ny*nx);
-
-	/* calculated values for every pressure level */
-	for (long l_pr=0; l_pr<n_plv; l_pr++) {
-		float p_cur = plvl[l_pr]; //pressure of current pressure level
-
-		for (long i=0; i<nt; i++) { // time dimension loop
-			for (long j=0; j<ny; j++) { // south_north dimension loop
-				for (long k=0; k<nx; k++) { // west_east dimension loop
-
-					/* find pressure interval in ustaggered grid for interpolation */
-					long l_lo = 0;
-					long l_up = 0;
-					for (long l_cur=1; l_cur<n_bts; l_cur++) {
-						long idx_cur = (i*n_btu*ny*nx)+(l_cur*ny*nx)+(j*nx)+k; //current index in unstaggered grid
-						float p_tmp = ((float*) p)[idx_cur] + ((float *) pb)[idx_cur]; // full pressure [Pa] is P+PB
-						l_lo = l_up;
-						l_up = l_cur;
-						if (p_tmp < p_cur) {
-							break;
-						}
-					}
 
-					/* interpolation indices */
-					long idx_lo = (i*n_btu*ny*nx)+(l_lo*ny*nx)+(j*nx)+k; // current of lower level index in unstaggered grid
-					long idx_up = (i*n_btu*ny*nx)+(l_up*ny*nx)+(j*nx)+k; // current of upper level index in unstaggered grid
-					long idx_pl = (i*n_plv*ny*nx)+(l_pr*ny*nx)+(j*nx)+k; // current index in pressure level grid
-
-					/* calculate variables for lower and upper levels.
-					 * (full pressure is calculated by perturbation + base state pressure [Pa])
-					 * (300.0 K base temperature has to be added to calculate potential temperature (see NCL) and
-					 * potential temperature has to be converted into temperature in [K] using full pressure in calc_tk())*/
-					float p_lo = ((float*) p)[idx_lo] + ((float *) pb)[idx_lo]; //lower level pressure [Pa]
-					float p_up = ((float*) p)[idx_up] + ((float *) pb)[idx_up]; //upper level pressure [Pa]
-					float t_lo = calc_tk(p_lo, ((float*) t)[idx_lo]+300.0); // lower level temperature [K]
-					float t_up = calc_tk(p_up, ((float*) t)[idx_up]+300.0); // upper level temperature [K]
-					float ght_lo = ((float*) ght_unstag)[idx_lo]; // lower level altitude [m]
-					float ght_up = ((float*) ght_unstag)[idx_up]; // upper level altitude [m]
-					float q_lo = ((float*)   qvapor)[idx_lo]; // lower level water vapor mixing ratio [kg/kg]
-					float q_up = ((float*)   qvapor)[idx_up]; // upper level water vapor mixing ratio [kg/kg]
-					float u_lo = ((float*) u_unstag)[idx_lo]; // lower level u wind vector [m s-1]
-					float u_up = ((float*) u_unstag)[idx_up]; // upper level u wind vector [m s-1]
-					float v_lo = ((float*) v_unstag)[idx_lo]; // lower level v wind vector [m s-1]
-					float v_up = ((float*) v_unstag)[idx_up]; // upper level v wind vector [m s-1]
-					float w_lo = ((float*) w_unstag)[idx_lo]; // lower level w wind vector [m s-1]
-					float w_up = ((float*) w_unstag)[idx_up]; // upper level w wind vector [m s-1]
-
-					/* interpolate temperature at current pressure level from upper and lower level values */
-					((float*) tt_press)[idx_pl] = // TT field
-						interpol(t_lo, t_up, p_lo, p_up, p_cur);
-
-					/* interpolate height at current pressure level from upper and lower level values */
-					((float*) ght_press)[idx_pl] = // GHT field
-						interpol(ght_lo, ght_up, p_lo, p_up, p_cur);
-
-					/* calculate/interpolate relative humidity for current pressure level from water vapor mixing ration, pressure
-					 * and temperature at upper and lower level.  */
-					((float*) rh_press)[idx_pl] = // RH field
-						interpol(calc_rh(q_lo, p_lo, t_lo), calc_rh(q_up, p_up, t_up), p_lo, p_up, p_cur);
-
-					/* interpolate u wind vector for current pressure level from upper and lower level values */
-					((float*) uu_press)[idx_pl] = // UU field
-						interpol(u_lo, u_up, p_lo, p_up, p_cur);
-
-					/* interpolate v wind vector for current pressure level from upper and lower level values */
-					((float*) vv_press)[idx_pl] = // VV field
-						interpol(v_lo, v_up, p_lo, p_up, p_cur);
-
-					/* interpolate vertical wind of current pressure level from upper and lower level values */
-					((float*) ww_press)[idx_pl] = // WW field
-						interpol(w_lo, w_up, p_lo, p_up, p_cur);
-				}
+		/* interpolate winds to heights above ground (brackets are searched once per column for all heights) */
+		AGLProfile agl_stag(nx, ny, n_bts, (float *) ght_stag, (float *) soilhgt, agl_w);
+		agl_stag.interpolate((float *) w, 0, (float *) w10); // W10		m s-1	200100.
+		if (n_agl > 0) {
+			AGLProfile agl_unstag(nx, ny, n_btu, (float *) ght_unstag, (float *) soilhgt, agl_levels);
+			for (long l=0; l<n_agl; l++) {
+				agl_unstag.interpolate((float *) u_unstag, l, &uu_agl[l*ny*nx]);
+				agl_unstag.interpolate((float *) v_unstag, l, &vv_agl[l*ny*nx]);
+				agl_stag.interpolate((float *) w, l+1, &ww_agl[l*ny*nx]);
 			}
 		}
-	}
-
-	/********************
-	 * print short info *
-	 ********************/
-	cout << "MAP_PROJ = " << proj.iproj << endl;
-	cout << "DX = " << proj.dx << ", DY = " << proj.dy << endl;
-	cout << "STARTLOC = " << proj.startloc << endl;
-	cout << "STARTLAT = " << proj.startlat << ", STARTLON = " << proj.startlon << endl;
-	cout << "STAND_LON = " << proj.xlonc << ", TRUELAT1 = " << proj.truelat1 << endl;
-	cout << "EARTH_RADIUS = " << proj.earth_radius << endl;
-	cout << "NT = " << nt << ", NX = " << proj.nx << ", NY = " << proj.ny << ", NSOIL = " << nsoil << endl;
-	cout << "TIMES[0] = " << time2str(Time, 0) << endl;
-	cout << "T2[0,0,0] = " << ((float *)t2k)[0] << endl;
-	cout << "U10[0,0,0] = " << ((float *)u10)[0] << endl;
-	cout << "V10[0,0,0] = " << ((float *)v10)[0] << endl;
-	cout << "W10[0,0,0] = " << ((float *)w10)[0] << endl;
-	cout << "RH2[0,0,0] = " << ((float *)rh2)[0] << endl;
 
-	/**********************
-	 * write output files *
-	 **********************/
-	for (long i=0; i<nt; i++) { /* one IFF for each time step */
-		string ofilename = opath+string("/WRF:")+time2str(Time,i);
-		cout << "Proceeding " << ofilename << " ...\n";
-
-		/* opening IFF */
-		ofstream ofile;
-		ofile.open(ofilename.c_str(), ios::out | ios::trunc | ios::binary);
-		if (!ofile) { /* test if output file opens */
-			cout << "Error opening file: " << ofilename << '\n';
-			return EXIT_FAILURE;
+		/****************************************************
+		 * calculate pressure/height above ground variables *
+		 ****************************************************/
+		/* load required variables */
+		void *p = read_step(&wrf, "P", i, win);
+		void *pb = read_step(&wrf, "PB", i, win);
+		void *t = read_step(&wrf, "T", i, win);
+		void *qvapor = read_step(&wrf, "QVAPOR", i, win);
+
+		/* output level variables (model level output points to model level arrays) */
+		void *tt_lvl = NULL, *rh_lvl = NULL, *uu_lvl = NULL, *vv_lvl = NULL, *ww_lvl = NULL, *ght_lvl = NULL;
+		void *pres_lvl = NULL; /* full pressure of height/model levels */
+		long n_src = n_lvl; /* number of levels in output level variables */
+		if (coord != LEVELS_NATIVE) {
+			tt_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
+			rh_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
+			uu_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
+			vv_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
+			ww_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
+			ght_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
 		}
 
-		/** write surface variables **/
+		if (coord == LEVELS_PRESSURE) {
+			/* calculated values for every pressure level */
+			for (long l_pr=0; l_pr<n_lvl; l_pr++) {
+				float p_cur = levels[l_pr]; //pressure of current pressure level
+
+				for (long j=0; j<ny; j++) { // south_north dimension loop
+					for (long k=0; k<nx; k++) { // west_east dimension loop
+
+						/* find pressure interval in ustaggered grid for interpolation */
+						long l_lo = 0;
+						long l_up = 0;
+						for (long l_cur=1; l_cur<n_btu; l_cur++) {
+							long idx_cur = (l_cur*ny*nx)+(j*nx)+k; //current index in unstaggered grid
+							float p_tmp = ((float*) p)[idx_cur] + ((float *) pb)[idx_cur]; // full pressure [Pa] is P+PB
+							l_lo = l_up;
+							l_up = l_cur;
+							if (p_tmp < p_cur) {
+								break;
+							}
+						}
 
-		/* writing surface temperature */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "TT", "K", "Temperature", t2k)) {
-			cout << "Error writing record: " << "sfc TT" << '\n';
-			return EXIT_FAILURE;
-		}
+						/* interpolation indices */
+						long idx_lo = (l_lo*ny*nx)+(j*nx)+k; // current of lower level index in unstaggered grid
+						long idx_up = (l_up*ny*nx)+(j*nx)+k; // current of upper level index in unstaggered grid
+						long idx_pl = (l_pr*ny*nx)+(j*nx)+k; // current index in pressure level grid
+
+						/* calculate variables for lower and upper levels.
+						 * (full pressure is calculated by perturbation + base state pressure [Pa])
+						 * (300.0 K base temperature has to be added to calculate potential temperature (see NCL) and
+						 * potential temperature has to be converted into temperature in [K] using full pressure in calc_tk())*/
+						float p_lo = ((float*) p)[idx_lo] + ((float *) pb)[idx_lo]; //lower level pressure [Pa]
+						float p_up = ((float*) p)[idx_up] + ((float *) pb)[idx_up]; //upper level pressure [Pa]
+						float t_lo = calc_tk(p_lo, ((float*) t)[idx_lo]+300.0); // lower level temperature [K]
+						float t_up = calc_tk(p_up, ((float*) t)[idx_up]+300.0); // upper level temperature [K]
+						float ght_lo = ((float*) ght_unstag)[idx_lo]; // lower level altitude [m]
+						float ght_up = ((float*) ght_unstag)[idx_up]; // upper level altitude [m]
+						float q_lo = ((float*)   qvapor)[idx_lo]; // lower level water vapor mixing ratio [kg/kg]
+						float q_up = ((float*)   qvapor)[idx_up]; // upper level water vapor mixing ratio [kg/kg]
+						float u_lo = ((float*) u_unstag)[idx_lo]; // lower level u wind vector [m s-1]
+						float u_up = ((float*) u_unstag)[idx_up]; // upper level u wind vector [m s-1]
+						float v_lo = ((float*) v_unstag)[idx_lo]; // lower level v wind vector [m s-1]
+						float v_up = ((float*) v_unstag)[idx_up]; // upper level v wind vector [m s-1]
+						float w_lo = ((float*) w_unstag)[idx_lo]; // lower level w wind vector [m s-1]
+						float w_up = ((float*) w_unstag)[idx_up]; // upper level w wind vector [m s-1]
+
+						/* interpolate temperature at current pressure level from upper and lower level values */
+						((float*) tt_lvl)[idx_pl] = // TT field
+							interpol(t_lo, t_up, p_lo, p_up, p_cur);
+
+						/* interpolate height at current pressure level from upper and lower level values */
+						((float*) ght_lvl)[idx_pl] = // GHT field
+							interpol(ght_lo, ght_up, p_lo, p_up, p_cur);
+
+						/* calculate/interpolate relative humidity for current pressure level from water vapor mixing ration, pressure
+						 * and temperature at upper and lower level.  */
+						((float*) rh_lvl)[idx_pl] = // RH field
+							interpol(calc_rh(q_lo, p_lo, t_lo), calc_rh(q_up, p_up, t_up), p_lo, p_up, p_cur);
+
+						/* interpolate u wind vector for current pressure level from upper and lower level values */
+						((float*) uu_lvl)[idx_pl] = // UU field
+							interpol(u_lo, u_up, p_lo, p_up, p_cur);
+
+						/* interpolate v wind vector for current pressure level from upper and lower level values */
+						((float*) vv_lvl)[idx_pl] = // VV field
+							interpol(v_lo, v_up, p_lo, p_up, p_cur);
+
+						/* interpolate vertical wind of current pressure level from upper and lower level values */
+						((float*) ww_lvl)[idx_pl] = // WW field
+							interpol(w_lo, w_up, p_lo, p_up, p_cur);
+					}
+				}
+			}
+		} else {
+			/* values of full model levels */
+			long n3d = n_btu*ny*nx;
+			float *p_full = (float *) pool.acquire(sizeof(float)*n3d);
+			float *t_full = (float *) pool.acquire(sizeof(float)*n3d);
+			float *rh_full = (float *) pool.acquire(sizeof(float)*n3d);
+			for (long idx=0; idx<n3d; idx++) {
+				p_full[idx] = ((float*) p)[idx] + ((float *) pb)[idx]; // full pressure [Pa] is P+PB
+				t_full[idx] = calc_tk(p_full[idx], ((float*) t)[idx]+300.0); // temperature [K]
+				rh_full[idx] = calc_rh(((float*) qvapor)[idx], p_full[idx], t_full[idx]); // relative humidity [%]
+			}
 
-		/* writing 10 m wind (u vector) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "UU", "m s-1", "U", u10)) {
-			cout << "Error writing record: " << "sfc UU" << '\n';
-			return EXIT_FAILURE;
+			if (coord == LEVELS_NATIVE) {
+				/* model levels are written directly (no interpolation) */
+				tt_lvl = t_full;		// TT field
+				rh_lvl = rh_full;		// RH field
+				uu_lvl = u_unstag;		// UU field
+				vv_lvl = v_unstag;		// VV field
+				ww_lvl = w_unstag;		// WW field
+				ght_lvl = ght_unstag;	// GHT field
+				pres_lvl = p_full;		// PRESSURE field
+				n_src = n_btu;
+			} else {
+				/* interpolate to heights above ground (one column search for all levels) */
+				pres_lvl = pool.acquire(sizeof(float)*n_lvl*ny*nx);
+				AGLProfile agl_lvl(nx, ny, n_btu, (float *) ght_unstag, (float *) soilhgt, levels);
+				for (long l=0; l<n_lvl; l++) {
+					long off = l*ny*nx;
+					agl_lvl.interpolate(t_full, l, &((float *) tt_lvl)[off]);			// TT field
+					agl_lvl.interpolate(rh_full, l, &((float *) rh_lvl)[off]);			// RH field
+					agl_lvl.interpolate((float *) u_unstag, l, &((float *) uu_lvl)[off]);	// UU field
+					agl_lvl.interpolate((float *) v_unstag, l, &((float *) vv_lvl)[off]);	// VV field
+					agl_lvl.interpolate((float *) w_unstag, l, &((float *) ww_lvl)[off]);	// WW field
+					agl_lvl.interpolate((float *) ght_unstag, l, &((float *) ght_lvl)[off]);	// GHT field
+					agl_lvl.interpolate(p_full, l, &((float *) pres_lvl)[off]);			// PRESSURE field
+				}
+			}
 		}
 
-		/* writing 10 m wind (v vector) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "VV", "m s-1", "V", v10)) {
-			cout << "Error writing record: " << "sfc VV" << '\n';
-			return EXIT_FAILURE;
+		/* print short info of first time step */
+		if (i == 0) {
+			cout << "TIMES[0] = " << time2str(Time, 0) << endl;
+			cout << "T2[0,0,0] = " << ((float *)t2k)[0] << endl;
+			cout << "U10[0,0,0] = " << ((float *)u10)[0] << endl;
+			cout << "V10[0,0,0] = " << ((float *)v10)[0] << endl;
+			cout << "W10[0,0,0] = " << ((float *)w10)[0] << endl;
+			cout << "RH2[0,0,0] = " << ((float *)rh2)[0] << endl;
 		}
 
-		/* writing 10 m wind (w vector) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "WW", "m s-1", "W", w10)) {
-			cout << "Error writing record: " << "sfc WW" << '\n';
-			return EXIT_FAILURE;
+		/**************************************************
+		 * regrid records to target grid (all levels of a *
+		 * field are written from the regridded buffers)  *
+		 **************************************************/
+		if (weights) {
+			t2k = regrid_levels(t2k, 1);
+			u10 = regrid_levels(u10, 1);
+			v10 = regrid_levels(v10, 1);
+			w10 = regrid_levels(w10, 1);
+			rh2 = regrid_levels(rh2, 1);
+			psfc = regrid_levels(psfc, 1);
+			smois = regrid_levels(smois, nsoil);
+			st = regrid_levels(st, nsoil);
+			seaice = regrid_levels(seaice, 1);
+			skintemp = regrid_levels(skintemp, 1);
+			sst = regrid_levels(sst, 1);
+			uu_agl = (float *) regrid_levels(uu_agl, n_agl);
+			vv_agl = (float *) regrid_levels(vv_agl, n_agl);
+			ww_agl = (float *) regrid_levels(ww_agl, n_agl);
+			tt_lvl = regrid_levels(tt_lvl, n_src);
+			rh_lvl = regrid_levels(rh_lvl, n_src);
+			uu_lvl = regrid_levels(uu_lvl, n_src);
+			vv_lvl = regrid_levels(vv_lvl, n_src);
+			ww_lvl = regrid_levels(ww_lvl, n_src);
+			ght_lvl = regrid_levels(ght_lvl, n_src);
+			pres_lvl = regrid_levels(pres_lvl, n_src);
 		}
 
-		/* writing surface humidity */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "RH", "%", "Relative Humidity", rh2)) {
-			cout << "Error writing record: " << "sfc RH" << '\n';
-			return EXIT_FAILURE;
-		}
+		/*********************
+		 * write output file *
+		 *********************/
+		cout << "Proceeding " << ofilename << " ...\n";
 
-		/* writing surface pressure */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "PSFC", "Pa", "Surface Pressure", psfc)) {
-			cout << "Error writing record: " << "PSFC" << '\n';
-			return EXIT_FAILURE;
-		}
+		/* IFF is complete before it appears under its name, so readers and reruns never see partial IFF */
+		bool written = write_atomic(ofilename, [&](ofstream &ofile) {
+			/** write surface variables **/
 
-		/* writing soil moisture (level 1) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SM000010", "fraction", "Soil Moist 0-10 cm below grn layer (Up)", sm000010)) {
-			cout << "Error writing record: " << "SM000010" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing surface temperature */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "TT", "K", "Temperature", t2k)) {
+				cout << "Error writing record: " << "sfc TT" << '\n';
+				return false;
+			}
 
-		/* writing soil moisture (level 2) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SM010040", "fraction", "Soil Moist 10-40 cm below grn layer", sm010040)) {
-			cout << "Error writing record: " << "SM010040" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing 10 m wind (u vector) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "UU", "m s-1", "U", u10)) {
+				cout << "Error writing record: " << "sfc UU" << '\n';
+				return false;
+			}
 
-		/* writing soil moisture (level 3) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SM040100", "fraction", "Soil Moist 40-100 cm below grn layer", sm040100)) {
-			cout << "Error writing record: " << "SM040100" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing 10 m wind (v vector) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "VV", "m s-1", "V", v10)) {
+				cout << "Error writing record: " << "sfc VV" << '\n';
+				return false;
+			}
 
-		/* writing soil moisture (level 4) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SM100200", "fraction", "Soil Moist 100-200 cm below grn layer", sm100200)) {
-			cout << "Error writing record: " << "SM100200" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing 10 m wind (w vector) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "WW", "m s-1", "W", w10)) {
+				cout << "Error writing record: " << "sfc WW" << '\n';
+				return false;
+			}
 
-		/* writing soil temperature (level 1) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "ST000010", "K", "T 0-10 cm below ground layer (Upper)", st000010)) {
-			cout << "Error writing record: " << "ST000010" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing surface humidity */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "RH", "%", "Relative Humidity", rh2)) {
+				cout << "Error writing record: " << "sfc RH" << '\n';
+				return false;
+			}
 
-		/* writing soil temperature (level 2) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "ST010040", "K", "T 10-40 cm below ground layer (Upper)", st010040)) {
-			cout << "Error writing record: " << "ST010040" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing surface pressure */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "PSFC", "Pa", "Surface Pressure", psfc)) {
+				cout << "Error writing record: " << "PSFC" << '\n';
+				return false;
+			}
 
-		/* writing soil temperature (level 3) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "ST040100", "K", "T 40-100 cm below ground layer (Upper)", st040100)) {
-			cout << "Error writing record: " << "ST040100" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil moisture (level 1) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "SM000010", "fraction", "Soil Moist 0-10 cm below grn layer (Up)", soil_layer(smois, 0))) {
+				cout << "Error writing record: " << "SM000010" << '\n';
+				return false;
+			}
 
-		/* writing soil temperature (level 4) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "ST100200", "K", "T 100-200 cm below ground layer (Bottom)", st100200)) {
-			cout << "Error writing record: " << "ST100200" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil moisture (level 2) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "SM010040", "fraction", "Soil Moist 10-40 cm below grn layer", soil_layer(smois, 1))) {
+				cout << "Error writing record: " << "SM010040" << '\n';
+				return false;
+			}
 
-		/* writing sea ice (SEAICE) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SEAICE", "proprtn", "Sea Ice Fraction (0-1)", seaice)) {
-			cout << "Error writing record: " << "SEAICE" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil moisture (level 3) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "SM040100", "fraction", "Soil Moist 40-100 cm below grn layer", soil_layer(smois, 2))) {
+				cout << "Error writing record: " << "SM040100" << '\n';
+				return false;
+			}
 
-		/* writing sea ice (XICE) */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "XICE", "0/1 Flag", "ice fraction data", seaice)) {
-			cout << "Error writing record: " << "XICE" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil moisture (level 4) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "SM100200", "fraction", "Soil Moist 100-200 cm below grn layer", soil_layer(smois, 3))) {
+				cout << "Error writing record: " << "SM100200" << '\n';
+				return false;
+			}
 
-		/* writing land sea mask */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "LANDSEA", "proprtn", "Land/Sea flag (1=land, 0 or 2=sea)", landsea)) {
-			cout << "Error writing record: " << "LANDSEA" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil temperature (level 1) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "ST000010", "K", "T 0-10 cm below ground layer (Upper)", soil_layer(st, 0))) {
+				cout << "Error writing record: " << "ST000010" << '\n';
+				return false;
+			}
 
-		/* writing model terrain */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SOILHGT", "m", "Terrain field of source analysis", soilhgt)) {
-			cout << "Error writing record: " << "SOILHGT" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil temperature (level 2) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "ST010040", "K", "T 10-40 cm below ground layer (Upper)", soil_layer(st, 1))) {
+				cout << "Error writing record: " << "ST010040" << '\n';
+				return false;
+			}
 
-		/* writing skin temperature */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SKINTEMP", "K", "Skin temperature", skintemp)) {
-			cout << "Error writing record: " << "SKINTEMP" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil temperature (level 3) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "ST040100", "K", "T 40-100 cm below ground layer (Upper)", soil_layer(st, 2))) {
+				cout << "Error writing record: " << "ST040100" << '\n';
+				return false;
+			}
 
-//		/* writing snow water equivalent */
-//		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SNOW", "kg m-2", "Water equivalent snow depth", snow)) {
-//			cout << "Error writing record: " << "SNOW" << '\n';
-//			return EXIT_FAILURE;
-//		}
-//		/* writing snow depth */
-//		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SNOWH", "m", "Physical Snow Depth", snowh)) {
-//			cout << "Error writing record: " << "SNOWH" << '\n';
-//			return EXIT_FAILURE;
-//		}
-
-		/* writing sea surface temperature */
-		if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, 200100.0, Time, i, 0, 1, "SST", "K", "Sea Surface Temperature", sst)) {
-			cout << "Error writing record: " << "SST" << '\n';
-			return EXIT_FAILURE;
-		}
+			/* writing soil temperature (level 4) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, "ST100200", "K", "T 100-200 cm below ground layer (Bottom)", soil_layer(st, 3))) {
+				cout << "Error writing record: " << "ST100200" << '\n';
+				return false;
+			}
 
-		/** write pressure variables **/
+			/* writing sea ice (SEAICE) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "SEAICE", "proprtn", "Sea Ice Fraction (0-1)", seaice)) {
+				cout << "Error writing record: " << "SEAICE" << '\n';
+				return false;
+			}
 
-		for (long pi=0; pi<n_plv; pi++) {
-			/* writing pressure level temperature */
-			if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, plvl[pi], Time, i, pi, n_plv, "TT", "K", "Temperature", tt_press)) {
-				cout << "Error writing record: " << "TT" << '\n';
-				return EXIT_FAILURE;
+			/* writing sea ice (XICE) */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "XICE", "0/1 Flag", "ice fraction data", seaice)) {
+				cout << "Error writing record: " << "XICE" << '\n';
+				return false;
 			}
 
-			/* writing pressure level vertical wind */
-			if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, plvl[pi], Time, i, pi, n_plv, "UU", "m s-1", "U", uu_press)) {
-				cout << "Error writing record: " << "UU" << '\n';
-				return EXIT_FAILURE;
+			/* writing land sea mask */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "LANDSEA", "proprtn", "Land/Sea flag (1=land, 0 or 2=sea)", landsea_out)) {
+				cout << "Error writing record: " << "LANDSEA" << '\n';
+				return false;
 			}
 
-			/* writing pressure level vertical wind */
-			if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, plvl[pi], Time, i, pi, n_plv, "VV", "m s-1", "V", vv_press)) {
-				cout << "Error writing record: " << "VV" << '\n';
-				return EXIT_FAILURE;
+			/* writing model terrain */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "SOILHGT", "m", "Terrain field of source analysis", soilhgt_out)) {
+				cout << "Error writing record: " << "SOILHGT" << '\n';
+				return false;
 			}
 
-			/* writing pressure level vertical wind */
-			if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, plvl[pi], Time, i, pi, n_plv, "WW", "m s-1", "W", ww_press)) {
-				cout << "Error writing record: " << "WW" << '\n';
-				return EXIT_FAILURE;
+			/* writing skin temperature */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "SKINTEMP", "K", "Skin temperature", skintemp)) {
+				cout << "Error writing record: " << "SKINTEMP" << '\n';
+				return false;
 			}
 
-			/* writing pressure level relative humidity */
-			if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, plvl[pi], Time, i, pi, n_plv, "RH", "%", "Relative Humidity", rh_press)) {
-				cout << "Error writing record: " << "RH" << '\n';
-				return EXIT_FAILURE;
+	//		/* writing snow water equivalent */
+	//		if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "SNOW", "kg m-2", "Water equivalent snow depth", snow)) {
+	//			cout << "Error writing record: " << "SNOW" << '\n';
+	//			return false;
+	//		}
+	//		/* writing snow depth */
+	//		if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "SNOWH", "m", "Physical Snow Depth", snowh)) {
+	//			cout << "Error writing record: " << "SNOWH" << '\n';
+	//			return false;
+	//		}
+
+			/* writing sea surface temperature */
+			if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, 0, 1, "SST", "K", "Sea Surface Temperature", sst)) {
+				cout << "Error writing record: " << "SST" << '\n';
+				return false;
 			}
 
-			/* writing pressure level height */
-			if (write_IFF_record(&ofile, proj, mapsource, 5, 0.0, plvl[pi], Time, i, pi, n_plv, "GHT", "m", "Height", ght_press)) {
-				cout << "Error writing record: " << "GHT" << '\n';
-				return EXIT_FAILURE;
+			/* writing winds at additional heights above ground */
+			for (long l=0; l<n_agl; l++) {
+				char suffix[8];
+				snprintf(suffix, sizeof(suffix), "%03dM", int(lround(agl_levels[l])));
+				string desc = string(" at ")+string(suffix, 3)+" m above ground";
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, l, n_agl, string("UU")+suffix, "m s-1", "U"+desc, uu_agl) or
+					write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, l, n_agl, string("VV")+suffix, "m s-1", "V"+desc, vv_agl) or
+					write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, IFF_XLVL_SURFACE, Time, 0, l, n_agl, string("WW")+suffix, "m s-1", "W"+desc, ww_agl)) {
+					cout << "Error writing record: " << "AGL " << suffix << '\n';
+					return false;
+				}
 			}
+
+			/** write pressure/height above ground/model level variables **/
+
+			for (long li=0; li<n_lvl; li++) {
+				long pi = (coord == LEVELS_NATIVE) ? long(levels[li])-1 : li; // level index in output level variables
+				/* writing pressure level temperature */
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "TT", "K", "Temperature", tt_lvl)) {
+					cout << "Error writing record: " << "TT" << '\n';
+					return false;
+				}
+
+				/* writing pressure level vertical wind */
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "UU", "m s-1", "U", uu_lvl)) {
+					cout << "Error writing record: " << "UU" << '\n';
+					return false;
+				}
+
+				/* writing pressure level vertical wind */
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "VV", "m s-1", "V", vv_lvl)) {
+					cout << "Error writing record: " << "VV" << '\n';
+					return false;
+				}
+
+				/* writing pressure level vertical wind */
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "WW", "m s-1", "W", ww_lvl)) {
+					cout << "Error writing record: " << "WW" << '\n';
+					return false;
+				}
+
+				/* writing pressure level relative humidity */
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "RH", "%", "Relative Humidity", rh_lvl)) {
+					cout << "Error writing record: " << "RH" << '\n';
+					return false;
+				}
+
+				/* writing pressure level height */
+				if (write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "GHT", "m", "Height", ght_lvl)) {
+					cout << "Error writing record: " << "GHT" << '\n';
+					return false;
+				}
+
+				/* writing pressure of height/model levels */
+				if (coord != LEVELS_PRESSURE and
+					write_IFF_record(&ofile, oproj, mapsource, 5, 0.0, levels[li], Time, 0, pi, n_src, "PRESSURE", "Pa", "Pressure", pres_lvl)) {
+					cout << "Error writing record: " << "PRESSURE" << '\n';
+					return false;
+				}
+			}
+			return true;
+		});
+		if (!written) {
+			cout << "Error writing file: " << ofilename << '\n';
+			return EXIT_FAILURE;
 		}
 
-		ofile.close();
+		/* record completed time step */
+		if (resume and file_crc32(ofilename, &step.crc, &step.bytes)) append_manifest(manifest_path, step);
+
+		/* return all buffers of current time step to pool */
+		pool.reset();
 	}
+	pool.print_stats("Buffer pool");
+	delete watch;
+	delete weights;
 
 	return EXIT_SUCCESS;
 }
@@ -10,7 +10,9 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <future>
 #include "libwrf.h"
+#include "QuickPlot.h"
 
 using namespace std;
 
@@ -19,8 +21,17 @@ void print_help(void) {
 	puts("COMMAND: WRF_dump <WRF output file>");
 	puts("OPIONS:  --variable=<variable> Dump only 'this' variable.");
 	puts("         --output=<opt>        Additionally output data for 'this' variable (1: print, 2: plot).");
-	puts("         --time=<step num>     Additionally output option required for 3D and 4D variables (first dim slicing)");
-	puts("         --slice=<level num>   Additionally output option required for 4D variables (second dim slicing)");
+	puts("         --time=<range>        Select time steps (first dim slicing).");
+	puts("         --level=<range>       Select vertical levels of 4D variables (second dim slicing, alias --slice).");
+	puts("         --y=<range>           Select south_north indices.");
+	puts("         --x=<range>           Select west_east indices.");
+	puts("                               <range> is <i>, <first>:<last> or <first>:<last>:<stride> (first/last may be omitted).");
+	puts("         --layout=<layout>     Layout of printed data: nested (default), ncdump or csv.");
+	puts("         --export=<file>       Write selected data of 'this' variable unformatted into file ('-': stdout).");
+	puts("         --format=<format>     Export format: raw (default, header in <file>.hdr) or npy.");
+	puts("         --png=<dir>           Render selected 2D frames of all float variables (or of 'this' variable) into PNG files.");
+	puts("         --stats               Print statistics of all numeric variables (or of 'this' variable).");
+	puts("         --threads=<n>         Number of threads used for statistics (default: all cores).");
 }
 
 /* dump dimension information */
@@ -72,18 +83,75 @@ void dump_variables(WRFncdf *w) {
     }
 }
 
-/* dump variable information and print/plot data if selected */
-void dump_this_variable(WRFncdf *w, string variable, int outopt, int step, int level, int argc) {
-	int stat = NC_NOERR;
-	int nvars, varid, ndims;
-	char vname[NC_MAX_NAME];
-	bool found = false;
+/* index range selected on command line (last < 0: up to last index of dimension) */
+struct Range {
+	bool set;
+	long first, last, stride;
+};
 
+/* dimensions which can be selected */
+enum Selector { SEL_TIME, SEL_LEVEL, SEL_Y, SEL_X, NSEL };
+
+/* parses range "<i>", "<first>:<last>" or "<first>:<last>:<stride>" (first/last may be omitted) */
+bool parse_range(string str, Range *r) {
+	r->set = true;
+	r->first = 0;
+	r->last = -1;
+	r->stride = 1;
+	size_t c1 = str.find(':');
+	if (c1 == string::npos) {
+		if (str.empty()) return false;
+		r->first = r->last = atol(str.c_str());
+		return r->first >= 0;
+	}
+	size_t c2 = str.find(':', c1+1);
+	string sfirst = str.substr(0, c1);
+	string slast = str.substr(c1+1, (c2 == string::npos) ? string::npos : c2-c1-1);
+	if (!sfirst.empty()) r->first = atol(sfirst.c_str());
+	if (!slast.empty()) r->last = atol(slast.c_str());
+	if (c2 != string::npos) r->stride = atol(str.substr(c2+1).c_str());
+	return r->first >= 0 and r->stride > 0 and (r->last < 0 or r->last >= r->first);
+}
+
+/* returns selector of dimension dimid of variable */
+int dim_selector(WRFncdf *w, string variable, int dimid) {
+	string dname = w->vardimname(variable, dimid);
+	if (dimid == 0 and !dname.compare(0,strlen("Time"),"Time")) return SEL_TIME;
+	if (!dname.compare(0,strlen("west_east"),"west_east")) return SEL_X;
+	if (!dname.compare(0,strlen("south_north"),"south_north")) return SEL_Y;
+	if (!dname.compare(0,strlen("bottom_top"),"bottom_top") or !dname.compare(0,strlen("soil_layers"),"soil_layers")) return SEL_LEVEL;
+	if (dimid == 1 and w->varndims(variable) == 4) return SEL_LEVEL;
+	return NSEL;
+}
+
+/* converts selected ranges into slab indices of variable (unselected dimensions are read completely) */
+void select_slab(WRFncdf *w, string variable, Range sel[NSEL], size_t *start, size_t *count, ptrdiff_t *stride) {
+	size_t *dims = w->vardims(variable);
+	for (int i = 0; i < w->varndims(variable); i++) {
+		long len = w->dimlen(dims[i]);
+		int s = dim_selector(w, variable, i);
+		Range r = {false, 0, len-1, 1};
+		if (s != NSEL and sel[s].set) r = sel[s];
+		if (r.last < 0 or r.last >= len) r.last = len-1;
+		if (r.first >= len) {
+			printf("ABORT: Index %li out of range for dimension %s (length %li)!\n", r.first, w->vardimname(variable, i).c_str(), len);
+			exit (EXIT_FAILURE);
+		}
+		start[i] = r.first;
+		count[i] = (r.last-r.first)/r.stride+1;
+		stride[i] = r.stride;
+	}
+}
+
+/* dump variable information and print/plot/export data if selected */
+void dump_this_variable(WRFncdf *w, string variable, int outopt, Range sel[NSEL], PrintLayout layout, bool quiet,
+		string expfile, ExportFormat format) {
 	/* check if selected variable exists */
-	varid = w->varid(variable);
 	if (w->varexist(variable)) {
-		printf("variables:\n");
-		dump_variable(w, variable);
+		if (!quiet) {
+			printf("variables:\n");
+			dump_variable(w, variable);
+		}
 	} else {
 		printf("ABORT: Variable %s not found!\n", variable.c_str());
 		exit (EXIT_FAILURE);
@@ -99,12 +167,6 @@ void dump_this_variable(WRFncdf *w, string variable, int outopt, int step, int l
        	exit (EXIT_FAILURE);
    	}
 
-   	if (outopt == 2 and w->varndims(variable) > argc-2) {
-    	printf("ABORT: Too few arguments plot %iD output!\n", w->varndims(variable));
-    	print_help();
-       	exit (EXIT_FAILURE);
-    }
-
     if (outopt == 2 and w->vartype(variable) == NC_CHAR) {
 		printf("ABORT: Character variables can only be plotted!\n");
        	exit (EXIT_FAILURE);
@@ -116,83 +178,221 @@ void dump_this_variable(WRFncdf *w, string variable, int outopt, int step, int l
            	exit (EXIT_FAILURE);
     }
 
-    /* print or plot data */
-   	switch(argc) {
-   	case 4:
-   		if (outopt == 1) w->printvardata(variable);
-   		if (outopt == 2) w->plotvardata(variable);
-		break;
-   	case 5:
-   		if (outopt == 1) w->printvardata(step, variable);
-   		if (outopt == 2) w->plotvardata(step, variable);
-		break;
-   	case 6:
-   		if (outopt == 1) w->printvardata(step, level, variable);
-   		if (outopt == 2) w->plotvardata(step, level, variable);
-		break;
-	default: break;
+    /* print, plot or export selected slab (only selected values are read) */
+   	if (outopt == 0 and expfile.empty()) return;
+   	int ndims = w->varndims(variable);
+   	size_t start[ndims], count[ndims];
+   	ptrdiff_t stride[ndims];
+   	select_slab(w, variable, sel, start, count, stride);
+   	if (outopt == 1) w->printslab(variable, start, count, stride, layout);
+   	if (outopt == 2) w->plotslab(variable, start, count, stride);
+   	if (!expfile.empty()) w->exportslab(variable, start, count, stride, expfile, format);
+}
+
+/* Renders selected slab of float variable frame by frame (last two dimensions)
+ * into image files <dir>/<variable>[_<dim><index>...].png
+ */
+void png_variable(WRFncdf *w, string variable, Range sel[NSEL], string dir) {
+	int ndims = w->varndims(variable);
+	if (w->vartype(variable) != NC_FLOAT or ndims < 2) return;
+
+	size_t start[ndims], count[ndims];
+	ptrdiff_t stride[ndims];
+	select_slab(w, variable, sel, start, count, stride);
+	size_t nx = count[ndims-1], ny = count[ndims-2];
+	if (nx < 2 or ny < 2) return;
+
+	/* frames are read one by one */
+	size_t nframes = 1;
+	size_t fstart[ndims], fcount[ndims];
+	for (int d = 0; d < ndims; d++) {
+		fstart[d] = start[d];
+		fcount[d] = (d < ndims-2) ? 1 : count[d];
+		if (d < ndims-2) nframes *= count[d];
+	}
+	float *frame = (float *)buffer_pool().acquire(nx*ny*sizeof(float));
+	for (size_t f = 0; f < nframes; f++) {
+		string path = dir + "/" + variable;
+		size_t rem = f;
+		for (int d = ndims-3; d >= 0; d--) {
+			fstart[d] = start[d] + (rem % count[d])*stride[d];
+			rem /= count[d];
+		}
+		for (int d = 0; d < ndims-2; d++) {
+			char idx[32];
+			snprintf(idx, sizeof(idx), "%0*zu", int(to_string(w->dimlen(w->vardims(variable)[d])-1).size()), fstart[d]);
+			path += "_" + w->vardimname(variable, d) + idx;
+		}
+		path += ".png";
+
+		w->vardata(variable, fstart, fcount, stride, frame);
+		float zmin, zmax;
+		vec_minmax(nx*ny, frame, &zmin, &zmax, true);
+		QuickPlotToFile(nx, ny, frame, path.c_str(), QP_COLORMAP_DEFAULT, zmin, zmax);
+	}
+	buffer_pool().release(frame);
+}
+
+/* Computes statistics of variable with value type T time step by time step.
+ * Reading of the next time step overlaps with the reduction of the current one.
+ */
+template <typename T> FieldStats var_stats(WRFncdf *w, string variable, int nthreads) {
+	int ndims = w->varndims(variable);
+	size_t *dims = w->vardims(variable);
+	size_t start[ndims], count[ndims];
+	size_t nsteps = 1, n = 1;
+	bool f_time = (ndims > 0 and !w->vardimname(variable, 0).compare(0,strlen("Time"),"Time"));
+	for (int i = 0; i < ndims; i++) {
+		start[i] = 0;
+		count[i] = w->dimlen(dims[i]);
+	}
+	if (f_time) {
+		nsteps = count[0];
+		count[0] = 1;
+	}
+	for (int i = 0; i < ndims; i++) n *= count[i];
+
+	FieldStats st;
+	if (n == 0) return st;
+	T *buf[2] = {(T *)buffer_pool().acquire(n*sizeof(T)), (T *)buffer_pool().acquire(n*sizeof(T))};
+	future<FieldStats> pending;
+	for (size_t t = 0; t < nsteps; t++) {
+		if (f_time) start[0] = t;
+		T *cur = buf[t%2];
+		w->vardata(variable, start, count, cur);
+		if (pending.valid()) st.merge(pending.get());
+		pending = async(launch::async, [=]() { return field_stats(n, cur, nthreads); });
+	}
+	st.merge(pending.get());
+	buffer_pool().release(buf[0]);
+	buffer_pool().release(buf[1]);
+	return st;
+}
+
+/* prints statistics table of selected variable or all numeric variables */
+void dump_stats(WRFncdf *w, string variable, int nthreads) {
+	printf("statistics:\n");
+	printf("        %-18s %-6s %12s %10s %14s %14s %14s %14s\n", "variable", "type", "count", "nans", "min", "max", "mean", "std");
+	for (int varid = 0; varid < w->nvars(); varid++) {
+		string vname = w->varname(varid);
+		if (!variable.empty() and vname != variable) continue;
+		FieldStats st;
+		switch (w->vartype(vname)) {
+		case NC_SHORT: st = var_stats<short>(w, vname, nthreads); break;
+		case NC_INT: st = var_stats<int>(w, vname, nthreads); break;
+		case NC_FLOAT: st = var_stats<float>(w, vname, nthreads); break;
+		case NC_DOUBLE: st = var_stats<double>(w, vname, nthreads); break;
+		default: continue; /* not numeric */
+		}
+		printf("        %-18s %-6s %12zu %10zu %14.7g %14.7g %14.7g %14.7g\n", vname.c_str(), w->vartypename(vname).c_str(),
+				st.count, st.nans, st.min, st.max, st.mean, st.std());
 	}
 }
 
 int main(int argc, char** argv) {
-	int step, level;
 	string ifilename, variable;
-	bool f_var;
+	bool f_var = false;
+	Range sel[NSEL] = {};
 	int outopt = 0;
+	PrintLayout layout = PRINT_NESTED;
+	string expfile;
+	ExportFormat format = EXPORT_RAW;
+	bool f_stats = false;
+	string pngdir;
+	int nthreads = 0;
 
 	/*********************************
 	 * Checking/extracting arguments *
 	 *********************************/
-	int found = 0;
-
-	if (argc < 2 or argc > 6) {
+	if (argc < 2) {
 		print_help();
 		return EXIT_FAILURE;
-	} else {
-		ifilename = string(argv[1]); /* extract input filename */
-		if (argc > 2) {
-			if (string(argv[2]).compare(0,strlen("--variable="),"--variable=")) {
-				puts("Second argument unknown (should be --variable=<variable>)");
+	}
+	ifilename = string(argv[1]); /* extract input filename */
+	for (int n=2; n<argc; n++) {
+		string arg = string(argv[n]);
+		if (!arg.compare(0,strlen("--variable="),"--variable=")) {
+			/* extract variable name */
+			variable = arg.substr(strlen("--variable="));
+			f_var = true;
+		} else if (!arg.compare(0,strlen("--output="),"--output=")) {
+			/* output option */
+			outopt = atoi(arg.substr(strlen("--output=")).c_str());
+		} else if (!arg.compare(0,strlen("--time="),"--time=")) {
+			/* extract time range */
+			if (!parse_range(arg.substr(strlen("--time=")), &sel[SEL_TIME])) {
+				printf("Range unknown: %s\n", arg.c_str());
 				print_help();
 				return EXIT_FAILURE;
-			} else
-			{
-				/* extract variable name */
-				variable = (string(argv[2])).substr(strlen("--variable="),strlen(argv[2])-strlen("--variable="));
-				f_var = true;
 			}
-		}
-		if (argc > 3) {
-			if (string(argv[3]).compare(0,strlen("--output="),"--output=")) {
-				puts("Third argument unknown (should be --output=<opt>)");
+		} else if (!arg.compare(0,strlen("--level="),"--level=") or !arg.compare(0,strlen("--slice="),"--slice=")) {
+			/* extract level range */
+			if (!parse_range(arg.substr(arg.find('=')+1), &sel[SEL_LEVEL])) {
+				printf("Range unknown: %s\n", arg.c_str());
 				print_help();
 				return EXIT_FAILURE;
-			} else {
-				/* output option */
-				outopt = atoi(((string(argv[3])).substr(strlen("--output="),strlen(argv[3])-strlen("--output="))).c_str());
 			}
-		}
-		if (argc > 4) {
-			if (string(argv[4]).compare(0,strlen("--time="),"--time=")) {
-				puts("Fourth argument unknown (should be --time=<step num>)");
+		} else if (!arg.compare(0,strlen("--y="),"--y=")) {
+			/* extract south_north range */
+			if (!parse_range(arg.substr(strlen("--y=")), &sel[SEL_Y])) {
+				printf("Range unknown: %s\n", arg.c_str());
 				print_help();
 				return EXIT_FAILURE;
-			} else {
-				/* extract time option */
-				step = atoi(((string(argv[4])).substr(strlen("--time="),strlen(argv[4])-strlen("--time="))).c_str());
 			}
-		}
-		if (argc == 6) {
-			if (string(argv[5]).compare(0,strlen("--slice="),"--slice=")) {
-				puts("Fifth argument unknown (should be --slice=<level num>)");
+		} else if (!arg.compare(0,strlen("--x="),"--x=")) {
+			/* extract west_east range */
+			if (!parse_range(arg.substr(strlen("--x=")), &sel[SEL_X])) {
+				printf("Range unknown: %s\n", arg.c_str());
+				print_help();
+				return EXIT_FAILURE;
+			}
+		} else if (!arg.compare(0,strlen("--layout="),"--layout=")) {
+			/* extract print layout */
+			string lay = arg.substr(strlen("--layout="));
+			if (lay == "nested") layout = PRINT_NESTED;
+			else if (lay == "ncdump") layout = PRINT_NCDUMP;
+			else if (lay == "csv") layout = PRINT_CSV;
+			else {
+				puts("Layout unknown (should be nested, ncdump or csv)");
 				print_help();
 				return EXIT_FAILURE;
+			}
+		} else if (!arg.compare(0,strlen("--export="),"--export=")) {
+			/* extract export file name */
+			expfile = arg.substr(strlen("--export="));
+		} else if (!arg.compare(0,strlen("--format="),"--format=")) {
+			/* extract export format */
+			string fmt = arg.substr(strlen("--format="));
+			if (fmt == "raw") format = EXPORT_RAW;
+			else if (fmt == "npy") format = EXPORT_NPY;
+			else if (fmt == "arrow") {
+				puts("Arrow export is not supported (no Arrow library available), use --format=npy instead");
+				return EXIT_FAILURE;
 			} else {
-				/* extract level option */
-				level = atoi(((string(argv[5])).substr(strlen("--slice="),strlen(argv[5])-strlen("--slice="))).c_str());
+				puts("Format unknown (should be raw or npy)");
+				print_help();
+				return EXIT_FAILURE;
 			}
+		} else if (!arg.compare(0,strlen("--png="),"--png=")) {
+			/* extract image directory */
+			pngdir = arg.substr(strlen("--png="));
+		} else if (arg == "--stats") {
+			f_stats = true;
+		} else if (!arg.compare(0,strlen("--threads="),"--threads=")) {
+			nthreads = atoi(arg.substr(strlen("--threads=")).c_str());
+		} else {
+			printf("Argument unknown: %s\n", arg.c_str());
+			print_help();
+			return EXIT_FAILURE;
 		}
 	}
+	if (!f_var and (outopt != 0 or !expfile.empty())) {
+		puts("Output and export options require --variable=<variable>");
+		print_help();
+		return EXIT_FAILURE;
+	}
+	/* print data only (csv layout or export to stdout) */
+	bool csv = (f_var and ((outopt == 1 and layout == PRINT_CSV) or expfile == "-"));
 
 	/*************
 	 * Open file *
@@ -202,25 +402,39 @@ int main(int argc, char** argv) {
 	/*********************
 	 * get netcdf format *
 	 *********************/
-	printf("format:\n");
-	printf("        %s ;\n", w.getformatstr().c_str());
+	if (!csv) {
+		printf("format:\n");
+		printf("        %s ;\n", w.getformatstr().c_str());
+	}
 
 
     /******************************
      * dump dimension information *
      ******************************/
-	dump_dimensions(&w);
+	if (!csv) dump_dimensions(&w);
 
     /**********************************
      * dump variable information/data *
      **********************************/
-	if (f_var) dump_this_variable(&w, variable, outopt, step, level, argc);
+	if (f_stats) dump_stats(&w, variable, nthreads);
+	else if (f_var) dump_this_variable(&w, variable, outopt, sel, layout, csv, expfile, format);
 	else dump_variables(&w);
 
+    /*****************
+     * render images *
+     *****************/
+	if (!pngdir.empty()) {
+		for (int varid = 0; varid < w.nvars(); varid++) {
+			if (f_var and w.varname(varid) != variable) continue;
+			png_variable(&w, w.varname(varid), sel, pngdir);
+		}
+		QuickPlotWait();
+	}
+
     /**************************
      * dump global attributes *
      **************************/
-    if (!f_var) dump_global_atts(&w);
+    if (!f_var and !f_stats) dump_global_atts(&w);
 
     /***************
      *  close file *
@@ -0,0 +1,338 @@
+/*
+ * WRF_extract.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Roman Finkelnburg
+ *   Copyright: Roman Finkelnburg (2026)
+ * Description: This tool extracts time series of surface variables at station locations
+ *              from a set of WRF output files into one table.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "libutils.h"
+#include "libwrf.h"
+#include "libgrid.h"
+
+using namespace std;
+
+/* print help text */
+void print_help(void) {
+	puts("COMMAND: WRF_extract <station file> <output file> <WRF output file> [<WRF output file> ...]");
+	puts("OPIONS:  --variables=<list>    Comma separated list of (Time, south_north, west_east) float variables");
+	puts("                               (default: T2,U10,V10,PSFC).");
+	puts("         --format=<format>     Output format: csv (default) or raw (float32 values, header in <output file>.hdr).");
+	puts("         --jobs=<n>            Number of WRF files read in parallel (default: all cores).");
+	puts("         --interp=<method>     Value at station: nearest (default, grid point nearest to station) or bilinear");
+	puts("                               (bilinear interpolation within enclosing grid cell).");
+	puts("         --cache=<dir>         Directory caching the grid index of the domain (default: no cache).");
+	puts("STATION FILE: one station per line '<name> <lat> <lon>' (lines starting with '#' are ignored).");
+}
+
+/* station location and its nearest grid point */
+struct Station {
+	string name;
+	double lat, lon;
+	size_t i, j;
+	double dist; /* distance to grid point in km */
+	GridWeights gw; /* bilinear weights of enclosing cell (only used for bilinear interpolation) */
+};
+
+/* reads station file */
+vector<Station> read_stations(string path) {
+	vector<Station> stations;
+	ifstream ifile(path.c_str());
+	if (!ifile.is_open()) {
+		cout << "ABORT: Cannot open station file " << path << "!\n";
+		exit(EXIT_FAILURE);
+	}
+	string line;
+	while (getline(ifile, line)) {
+		if (line.empty() or line[0] == '#') continue;
+		istringstream iss(line);
+		Station s;
+		if (!(iss >> s.name >> s.lat >> s.lon)) {
+			cout << "ABORT: Invalid station line '" << line << "' in " << path << "!\n";
+			exit(EXIT_FAILURE);
+		}
+		stations.push_back(s);
+	}
+	if (stations.empty()) {
+		cout << "ABORT: No stations found in " << path << "!\n";
+		exit(EXIT_FAILURE);
+	}
+	return stations;
+}
+
+/* splits comma separated list */
+vector<string> split_list(string list) {
+	vector<string> items;
+	string item;
+	istringstream iss(list);
+	while (getline(iss, item, ',')) if (!item.empty()) items.push_back(item);
+	return items;
+}
+
+/* checks that variable is a float surface variable of size nx*ny */
+void check_variable(WRFncdf *w, string vname, size_t nx, size_t ny) {
+	if (!w->varexist(vname)) {
+		cout << "ABORT: Variable " << vname << " not found in " << w->getname() << "!\n";
+		exit(EXIT_FAILURE);
+	}
+	if (w->vartype(vname) != NC_FLOAT or w->varndims(vname) != 3
+			or w->vardimname(vname, 1) != "south_north" or w->vardimname(vname, 2) != "west_east"
+			or w->dimlen(w->vardims(vname)[1]) != ny or w->dimlen(w->vardims(vname)[2]) != nx) {
+		cout << "ABORT: Variable " << vname << " in " << w->getname() << " is no float (Time, south_north, west_east) variable of the station grid!\n";
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Extracts station time series of one WRF file into temporary file.
+ * Only the (time, j, i) columns of the stations (the 2x2 columns of the enclosing cells if bilinear) are read.
+ * Temporary file layout: nt, nt time stamps (19 chars), nt*nstations*nvars floats (time, station, variable).
+ */
+void extract_file(string ifilename, string tmpname, const vector<Station> &stations, const vector<string> &vars,
+		size_t nx, size_t ny, bool bilinear) {
+	WRFncdf wrf(ifilename);
+	size_t nt = wrf.dimlen(wrf.dimid("Time"));
+	size_t ns = stations.size(), nv = vars.size();
+
+	for (size_t v=0; v<nv; v++) check_variable(&wrf, vars[v], nx, ny);
+
+	vector<char> times(nt*19+1, '\0');
+	if (nt > 0) {
+		size_t tstart[2] = {0,0}, tcount[2] = {nt,19};
+		wrf.vardata("Times", tstart, tcount, &times[0]);
+	}
+
+	vector<float> values(nt*ns*nv);
+	vector<float> column(4*nt);
+	for (size_t s=0; s<ns and nt>0; s++) {
+		if (!bilinear) {
+			size_t start[3] = {0, stations[s].j, stations[s].i};
+			size_t count[3] = {nt, 1, 1};
+			for (size_t v=0; v<nv; v++) {
+				wrf.vardata(vars[v], start, count, &column[0]);
+				for (size_t t=0; t<nt; t++) values[(t*ns+s)*nv+v] = column[t];
+			}
+		} else {
+			const GridWeights &gw = stations[s].gw;
+			size_t start[3] = {0, gw.j, gw.i};
+			size_t count[3] = {nt, 2, 2};
+			for (size_t v=0; v<nv; v++) {
+				wrf.vardata(vars[v], start, count, &column[0]);
+				for (size_t t=0; t<nt; t++) {
+					double val = 0;
+					for (int c=0; c<4; c++) if (gw.w[c] != 0) val += gw.w[c]*column[4*t+c];
+					values[(t*ns+s)*nv+v] = val;
+				}
+			}
+		}
+	}
+
+	ofstream ofile(tmpname.c_str(), ios::binary);
+	unsigned long long n = nt;
+	ofile.write((const char *)&n, sizeof(n));
+	ofile.write(times.data(), nt*19);
+	ofile.write((const char *)values.data(), values.size()*sizeof(float));
+	if (!ofile.good()) {
+		cout << "ABORT: Cannot write temporary file " << tmpname << "!\n";
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(int argc, char** argv) {
+	string stationfile, ofilename, format = "csv", interp = "nearest", cachedir;
+	vector<string> ifilenames;
+	vector<string> vars = split_list("T2,U10,V10,PSFC");
+	long njobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+	/* check input */
+	for (int a=1; a<argc; a++) {
+		string arg = string(argv[a]);
+		if (!arg.compare(0,strlen("--variables="),"--variables=")) {
+			vars = split_list(arg.substr(strlen("--variables=")));
+		} else if (!arg.compare(0,strlen("--format="),"--format=")) {
+			format = arg.substr(strlen("--format="));
+		} else if (!arg.compare(0,strlen("--jobs="),"--jobs=")) {
+			njobs = atol(arg.substr(strlen("--jobs=")).c_str());
+		} else if (!arg.compare(0,strlen("--interp="),"--interp=")) {
+			interp = arg.substr(strlen("--interp="));
+		} else if (!arg.compare(0,strlen("--cache="),"--cache=")) {
+			cachedir = arg.substr(strlen("--cache="));
+		} else if (!arg.compare(0,2,"--")) {
+			cout << "ABORT: Unknown option " << arg << "!\n";
+			print_help();
+			exit(EXIT_FAILURE);
+		} else if (stationfile.empty()) {
+			stationfile = arg;
+		} else if (ofilename.empty()) {
+			ofilename = arg;
+		} else {
+			ifilenames.push_back(arg);
+		}
+	}
+	if (ifilenames.empty() or vars.empty()) {
+		print_help();
+		exit(EXIT_FAILURE);
+	}
+	if (format != "csv" and format != "raw") {
+		cout << "ABORT: Unknown output format " << format << "!\n";
+		print_help();
+		exit(EXIT_FAILURE);
+	}
+	if (interp != "nearest" and interp != "bilinear") {
+		cout << "ABORT: Unknown interpolation method " << interp << "!\n";
+		print_help();
+		exit(EXIT_FAILURE);
+	}
+	bool bilinear = (interp == "bilinear");
+	if (njobs < 1) njobs = 1;
+	if (njobs > long(ifilenames.size())) njobs = ifilenames.size();
+
+	/**********************************************
+	 * map stations to grid (index is built once) *
+	 **********************************************/
+	vector<Station> stations = read_stations(stationfile);
+	size_t nx, ny;
+	{
+		WRFncdf wrf(ifilenames[0]);
+		nx = wrf.dimlen(wrf.dimid("west_east"));
+		ny = wrf.dimlen(wrf.dimid("south_north"));
+		check_variable(&wrf, "XLAT", nx, ny);
+		check_variable(&wrf, "XLONG", nx, ny);
+		vector<float> lat(nx*ny), lon(nx*ny);
+		size_t start[3] = {0,0,0}, count[3] = {1,ny,nx};
+		wrf.vardata("XLAT", start, count, &lat[0]);
+		wrf.vardata("XLONG", start, count, &lon[0]);
+
+		GridIndex index(nx, ny, &lat[0], &lon[0], cachedir);
+		if (index.cached()) printf("Grid index %016llx loaded from %s\n", index.hash(), cachedir.c_str());
+		for (size_t s=0; s<stations.size(); s++) {
+			index.nearest(stations[s].lat, stations[s].lon, &stations[s].i, &stations[s].j, &stations[s].dist);
+			printf("%s: lat=%g lon=%g -> i=%zu j=%zu (XLAT=%g XLONG=%g, %.2f km)\n", stations[s].name.c_str(),
+					stations[s].lat, stations[s].lon, stations[s].i, stations[s].j,
+					lat[stations[s].j*nx+stations[s].i], lon[stations[s].j*nx+stations[s].i], stations[s].dist);
+			if (bilinear and !index.bilinear(stations[s].lat, stations[s].lon, &stations[s].gw)) {
+				printf("WARNING: Station %s is outside of grid, nearest grid point is used\n", stations[s].name.c_str());
+			}
+		}
+	}
+
+	/*************************************************************************
+	 * extract files in parallel (processes, since netCDF is not threadsafe) *
+	 *************************************************************************/
+	size_t nf = ifilenames.size();
+	vector<string> tmpnames(nf);
+	for (size_t f=0; f<nf; f++) {
+		ostringstream oss;
+		oss << ofilename << "." << f << ".tmp";
+		tmpnames[f] = oss.str();
+	}
+	fflush(stdout);
+	cout.flush();
+	vector<pid_t> pids;
+	for (long job=0; job<njobs; job++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			cout << "ABORT: Cannot fork extraction process!\n";
+			exit(EXIT_FAILURE);
+		}
+		if (pid == 0) {
+			for (size_t f=job; f<nf; f+=njobs) {
+				extract_file(ifilenames[f], tmpnames[f], stations, vars, nx, ny, bilinear);
+			}
+			cout.flush();
+			_exit(EXIT_SUCCESS);
+		}
+		pids.push_back(pid);
+	}
+	bool failed = false;
+	for (size_t p=0; p<pids.size(); p++) {
+		int status;
+		waitpid(pids[p], &status, 0);
+		if (!WIFEXITED(status) or WEXITSTATUS(status) != EXIT_SUCCESS) failed = true;
+	}
+	if (failed) {
+		for (size_t f=0; f<nf; f++) remove(tmpnames[f].c_str());
+		cout << "ABORT: Extraction failed!\n";
+		exit(EXIT_FAILURE);
+	}
+
+	/***************************************
+	 * merge temporary files in file order *
+	 ***************************************/
+	size_t ns = stations.size(), nv = vars.size(), ntotal = 0;
+	vector<string> times;
+	ofstream ofile(ofilename.c_str(), format == "raw" ? ios::binary : ios::out);
+	if (!ofile.is_open()) {
+		cout << "ABORT: Cannot open output file " << ofilename << "!\n";
+		exit(EXIT_FAILURE);
+	}
+	if (format == "csv") {
+		ofile << "station,lat,lon,i,j,time";
+		for (size_t v=0; v<nv; v++) ofile << "," << vars[v];
+		ofile << "\n";
+	}
+	for (size_t f=0; f<nf; f++) {
+		ifstream ifile(tmpnames[f].c_str(), ios::binary);
+		unsigned long long nt = 0;
+		ifile.read((char *)&nt, sizeof(nt));
+		vector<char> tbuf(nt*19+1, '\0');
+		vector<float> values(nt*ns*nv);
+		ifile.read(tbuf.data(), nt*19);
+		ifile.read((char *)values.data(), values.size()*sizeof(float));
+		if (!ifile.good()) {
+			cout << "ABORT: Cannot read temporary file " << tmpnames[f] << "!\n";
+			exit(EXIT_FAILURE);
+		}
+		ifile.close();
+		remove(tmpnames[f].c_str());
+
+		for (size_t t=0; t<nt; t++) {
+			string tstr = string(&tbuf[t*19], 19);
+			times.push_back(tstr);
+			if (format == "raw") continue;
+			for (size_t s=0; s<ns; s++) {
+				ofile << stations[s].name << "," << stations[s].lat << "," << stations[s].lon << ","
+						<< stations[s].i << "," << stations[s].j << "," << tstr;
+				for (size_t v=0; v<nv; v++) { /* shortest representation reading back exactly (ostream keeps 6 digits) */
+					char buf[32];
+					ofile << "," << string(buf, to_chars(buf, buf+sizeof(buf), values[(t*ns+s)*nv+v]).ptr);
+				}
+				ofile << "\n";
+			}
+		}
+		if (format == "raw") ofile.write((const char *)values.data(), values.size()*sizeof(float));
+		ntotal += nt;
+	}
+	ofile.close();
+
+	/* header of raw table */
+	if (format == "raw") {
+		ofstream hfile((ofilename+".hdr").c_str());
+		hfile << "type float32\n";
+		hfile << "order host\n";
+		hfile << "shape " << ntotal << " " << ns << " " << nv << "\n";
+		hfile << "dims time station variable\n";
+		hfile << "interp " << interp << "\n";
+		hfile << "variables";
+		for (size_t v=0; v<nv; v++) hfile << " " << vars[v];
+		hfile << "\n";
+		for (size_t s=0; s<ns; s++) {
+			hfile << "station " << stations[s].name << " " << stations[s].lat << " " << stations[s].lon << " "
+					<< stations[s].i << " " << stations[s].j << " " << stations[s].dist << "\n";
+		}
+		for (size_t t=0; t<times.size(); t++) hfile << "time " << times[t] << "\n";
+	}
+	printf("%zu stations, %zu variables, %zu time steps from %zu files written to %s\n", ns, nv, ntotal, nf, ofilename.c_str());
+
+	return EXIT_SUCCESS;
+}
@@ -5,7 +5,7 @@ lib_dir="/usr/local/"
 
 #clean up before build/install
 make clean 
-for link in "lib/libutils.so" "include/libutils.h" "lib/libiff.so" "include/libiff.h" "lib/libwrf.so" "include/libwrf.h" "lib/libgeo.so" "include/libgeo.h"
+for link in "lib/libutils.so" "include/libutils.h" "include/libfield.h" "lib/libiff.so" "include/libiff.h" "lib/libwrf.so" "include/libwrf.h" "lib/libgeo.so" "include/libgeo.h" "lib/libgrid.so" "include/libgrid.h"
 do
         if [ -L $lib_dir/$link ]; then
                 sudo rm $lib_dir/$link
@@ -16,6 +16,7 @@ done
 make libutils
 sudo ln -s $dir/libutils.h $lib_dir/include/libutils.h
 sudo ln -s $dir/libutils.so $lib_dir/lib/libutils.so
+sudo ln -s $dir/libfield.h $lib_dir/include/libfield.h
 
 #build and install libiff
 make libiff
@@ -32,6 +33,11 @@ make libgeo
 sudo ln -s $dir/libgeo.h $lib_dir/include/libgeo.h
 sudo ln -s $dir/libgeo.so $lib_dir/lib/libgeo.so
 
+#build and install libgrid
+make libgrid
+sudo ln -s $dir/libgrid.h $lib_dir/include/libgrid.h
+sudo ln -s $dir/libgrid.so $lib_dir/lib/libgrid.so
+
 #build IFF_dump
 make IFF_dump
 
@@ -47,8 +53,14 @@ make WRF_copy
 #install WRF2IFF
 make WRF2IFF
 
+#install WRF_extract
+make WRF_extract
+
 #install GEO_dump
 make GEO_dump
 
 #install GEO_copy
 make GEO_copy
+
+#install GEO_crop
+make GEO_crop
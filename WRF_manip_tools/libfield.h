@@ -0,0 +1,201 @@
+/*
+ * libfield.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Roman Finkelnburg
+ *   Copyright: Roman Finkelnburg (2026)
+ * Description: Contiguous 2D/3D field containers used by WRF_manip_tools.
+ *              Fields are stored in one aligned block with x as fastest varying
+ *              dimension, i.e. in the order used by IFF and geogrid files.
+ */
+
+#ifndef LIBFIELD_H_
+#define LIBFIELD_H_
+
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include "libutils.h"
+
+using namespace std;
+
+/* alignment of field storage in Bytes (suits AVX/AVX-512 loads) */
+const size_t FIELD_ALIGN = 64;
+
+/* allocates aligned, uninitialized storage for n values of type T
+ * (taken from pool if given, BufferPool buffers are aligned to FIELD_ALIGN as well) */
+template <typename T> T *field_alloc(size_t n, BufferPool *pool = NULL) {
+	void *p = NULL;
+	if (n == 0) return NULL;
+	if (pool) return (T *)pool->acquire(n*sizeof(T));
+	if (posix_memalign(&p, FIELD_ALIGN, n*sizeof(T)) != 0) {
+		cout << "ABORT: Error allocating memory for " << n << " field values!\n";
+		exit(EXIT_FAILURE);
+	}
+	return (T *)p;
+}
+
+/* frees storage allocated by field_alloc */
+template <typename T> void field_free(T *p, BufferPool *pool) {
+	if (pool) pool->release(p);
+	else free(p);
+}
+
+/* Non-owning strided view on n values (similar to std::span).
+ * Rows of a field have stride 1, columns have stride nx.
+ */
+template <typename T> class FieldSpan {
+public:
+	FieldSpan() : ptr(NULL), len(0), step(1) {}
+	FieldSpan(T *ptr, size_t len, ptrdiff_t step = 1) : ptr(ptr), len(len), step(step) {}
+
+	size_t size() const { return len; }
+	bool empty() const { return len == 0; }
+	ptrdiff_t stride() const { return step; }
+	bool contiguous() const { return step == 1; }
+	T *data() const { return ptr; }
+	T &operator[](size_t i) const { return ptr[ptrdiff_t(i)*step]; }
+
+	/* returns view on count elements starting at element off */
+	FieldSpan subspan(size_t off, size_t count) const {
+		if (off+count > len) {
+			cout << "ABORT: Subspan " << off << "+" << count << " exceeds span of " << len << " elements!\n";
+			exit(EXIT_FAILURE);
+		}
+		return FieldSpan(ptr+ptrdiff_t(off)*step, count, step);
+	}
+	FieldSpan first(size_t count) const { return subspan(0, count); }
+	FieldSpan last(size_t count) const { return subspan(len-count, count); }
+
+	/* copies viewed elements into contiguous array dst */
+	void copy_to(typename remove_const<T>::type *dst) const {
+		if (step == 1) memcpy(dst, ptr, len*sizeof(T));
+		else for (size_t i=0; i<len; i++) dst[i] = ptr[ptrdiff_t(i)*step];
+	}
+
+private:
+	T *ptr;
+	size_t len;
+	ptrdiff_t step;
+};
+
+/* 2D field of nx*ny values, element (i,j) is stored at j*nx+i */
+template <typename T> class Field2D {
+public:
+	Field2D() : n_x(0), n_y(0), buf(NULL), pool(NULL) {}
+	/* storage is taken from pool if given and returned to it on destruction
+	 * (pool-backed fields have to be destroyed before the pool is reset) */
+	Field2D(size_t nx, size_t ny, BufferPool *pool = NULL) : n_x(nx), n_y(ny), buf(field_alloc<T>(nx*ny, pool)), pool(pool) {}
+	/* copies nx*ny values (x fastest varying) from src */
+	Field2D(size_t nx, size_t ny, const T *src, BufferPool *pool = NULL) : n_x(nx), n_y(ny), buf(field_alloc<T>(nx*ny, pool)), pool(pool) {
+		if (nx*ny > 0) memcpy(buf, src, nx*ny*sizeof(T));
+	}
+	Field2D(Field2D &&o) : n_x(o.n_x), n_y(o.n_y), buf(o.buf), pool(o.pool) { o.n_x = o.n_y = 0; o.buf = NULL; }
+	Field2D &operator=(Field2D &&o) {
+		if (this != &o) {
+			field_free(buf, pool);
+			n_x = o.n_x; n_y = o.n_y; buf = o.buf; pool = o.pool;
+			o.n_x = o.n_y = 0; o.buf = NULL;
+		}
+		return *this;
+	}
+	Field2D(const Field2D &) = delete;
+	Field2D &operator=(const Field2D &) = delete;
+	~Field2D() { field_free(buf, pool); }
+
+	size_t nx() const { return n_x; }
+	size_t ny() const { return n_y; }
+	size_t size() const { return n_x*n_y; }
+	size_t bytes() const { return n_x*n_y*sizeof(T); }
+	T *data() { return buf; }
+	const T *data() const { return buf; }
+
+	T &operator()(size_t i, size_t j) { return buf[j*n_x+i]; }
+	const T &operator()(size_t i, size_t j) const { return buf[j*n_x+i]; }
+
+	/* views on whole field, row j (x direction) and column i (y direction) */
+	FieldSpan<T> span() { return FieldSpan<T>(buf, size()); }
+	FieldSpan<const T> span() const { return FieldSpan<const T>(buf, size()); }
+	FieldSpan<T> row(size_t j) { return FieldSpan<T>(&buf[j*n_x], n_x); }
+	FieldSpan<const T> row(size_t j) const { return FieldSpan<const T>(&buf[j*n_x], n_x); }
+	FieldSpan<T> column(size_t i) { return FieldSpan<T>(&buf[i], n_y, n_x); }
+	FieldSpan<const T> column(size_t i) const { return FieldSpan<const T>(&buf[i], n_y, n_x); }
+
+	void fill(T val) { for (size_t i=0; i<size(); i++) buf[i] = val; }
+
+	/* returns column-major copy (element (i,j) at i*ny+j) */
+	Field2D transposed() const {
+		Field2D t(n_y, n_x, pool);
+		for (size_t j=0; j<n_y; j++)
+			for (size_t i=0; i<n_x; i++)
+				t.buf[i*n_y+j] = buf[j*n_x+i];
+		return t;
+	}
+
+private:
+	size_t n_x, n_y;
+	T *buf;
+	BufferPool *pool;
+};
+
+/* 3D field of nx*ny*nz values, element (i,j,k) is stored at (k*ny+j)*nx+i */
+template <typename T> class Field3D {
+public:
+	Field3D() : n_x(0), n_y(0), n_z(0), buf(NULL), pool(NULL) {}
+	/* storage is taken from pool if given and returned to it on destruction */
+	Field3D(size_t nx, size_t ny, size_t nz, BufferPool *pool = NULL) : n_x(nx), n_y(ny), n_z(nz), buf(field_alloc<T>(nx*ny*nz, pool)), pool(pool) {}
+	/* copies nx*ny*nz values (x fastest varying) from src */
+	Field3D(size_t nx, size_t ny, size_t nz, const T *src, BufferPool *pool = NULL) : n_x(nx), n_y(ny), n_z(nz), buf(field_alloc<T>(nx*ny*nz, pool)), pool(pool) {
+		if (nx*ny*nz > 0) memcpy(buf, src, nx*ny*nz*sizeof(T));
+	}
+	Field3D(Field3D &&o) : n_x(o.n_x), n_y(o.n_y), n_z(o.n_z), buf(o.buf), pool(o.pool) { o.n_x = o.n_y = o.n_z = 0; o.buf = NULL; }
+	Field3D &operator=(Field3D &&o) {
+		if (this != &o) {
+			field_free(buf, pool);
+			n_x = o.n_x; n_y = o.n_y; n_z = o.n_z; buf = o.buf; pool = o.pool;
+			o.n_x = o.n_y = o.n_z = 0; o.buf = NULL;
+		}
+		return *this;
+	}
+	Field3D(const Field3D &) = delete;
+	Field3D &operator=(const Field3D &) = delete;
+	~Field3D() { field_free(buf, pool); }
+
+	size_t nx() const { return n_x; }
+	size_t ny() const { return n_y; }
+	size_t nz() const { return n_z; }
+	size_t size() const { return n_x*n_y*n_z; }
+	size_t bytes() const { return size()*sizeof(T); }
+	T *data() { return buf; }
+	const T *data() const { return buf; }
+
+	T &operator()(size_t i, size_t j, size_t k) { return buf[(k*n_y+j)*n_x+i]; }
+	const T &operator()(size_t i, size_t j, size_t k) const { return buf[(k*n_y+j)*n_x+i]; }
+
+	/* views on whole field, level k, row j of level k and column i of level k */
+	FieldSpan<T> span() { return FieldSpan<T>(buf, size()); }
+	FieldSpan<const T> span() const { return FieldSpan<const T>(buf, size()); }
+	FieldSpan<T> level(size_t k) { return FieldSpan<T>(&buf[k*n_x*n_y], n_x*n_y); }
+	FieldSpan<const T> level(size_t k) const { return FieldSpan<const T>(&buf[k*n_x*n_y], n_x*n_y); }
+	FieldSpan<T> row(size_t j, size_t k) { return FieldSpan<T>(&buf[(k*n_y+j)*n_x], n_x); }
+	FieldSpan<const T> row(size_t j, size_t k) const { return FieldSpan<const T>(&buf[(k*n_y+j)*n_x], n_x); }
+	FieldSpan<T> column(size_t i, size_t k) { return FieldSpan<T>(&buf[k*n_x*n_y+i], n_y, n_x); }
+	FieldSpan<const T> column(size_t i, size_t k) const { return FieldSpan<const T>(&buf[k*n_x*n_y+i], n_y, n_x); }
+	/* vertical profile at (i,j) */
+	FieldSpan<T> profile(size_t i, size_t j) { return FieldSpan<T>(&buf[j*n_x+i], n_z, n_x*n_y); }
+	FieldSpan<const T> profile(size_t i, size_t j) const { return FieldSpan<const T>(&buf[j*n_x+i], n_z, n_x*n_y); }
+
+	/* returns copy of level k as 2D field */
+	Field2D<T> copy_level(size_t k) const { return Field2D<T>(n_x, n_y, &buf[k*n_x*n_y], pool); }
+
+	void fill(T val) { for (size_t i=0; i<size(); i++) buf[i] = val; }
+
+private:
+	size_t n_x, n_y, n_z;
+	T *buf;
+	BufferPool *pool;
+};
+
+#endif /* LIBFIELD_H_ */
@@ -11,6 +11,9 @@
 #include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "libutils.h"
 #include "libgeo.h"
@@ -24,13 +27,15 @@ void Geogrid::Init(string f) {
 	if ((this->d_name.substr(0,this->d_name.find_last_of("/"))).length() != this->d_name.length()) {
 		this->h_name = this->d_name.substr(0,this->d_name.find_last_of("/"))+"/index";
 	} else this->h_name = "index";
+	this->header_loaded = false;
+	this->data_loaded = false;
 
 	/**************************
 	 * Load index/header file *
 	 **************************/
 	if (!this->newfile) {
 		this->read_headerfile();
-		this->read_datafile();
+		if (this->load_data) this->read_datafile();
 	}
 }
 
@@ -124,23 +129,106 @@ void Geogrid::read_datafile(void) {
 
     this->data = (float *)malloc(sizeof(float)*this->n_elem);
 
-    size_t elem = 0;
-    for (size_t i=0; i<this->n_elem; i++) {
-    	this->data[i] = float(b2s((char*)(&this->memblock[elem]), true));
-    	elem += this->header.wordsize;
+    if (this->header.wordsize == 2) { /* decode whole block at once */
+    	short *values = (short *)malloc(sizeof(short)*this->n_elem);
+    	decode_n<ENDIAN_GEO>(this->memblock, values, this->n_elem);
+    	for (size_t i=0; i<this->n_elem; i++) this->data[i] = float(values[i]);
+    	free(values);
+    } else {
+    	size_t elem = 0;
+    	for (size_t i=0; i<this->n_elem; i++) {
+    		this->data[i] = float(decode<ENDIAN_GEO,short>((char*)(&this->memblock[elem])));
+    		elem += this->header.wordsize;
+    	}
     }
 	this->data_loaded = true;
 }
 
+/* reads sub-window of one level directly from data file (without loading the whole tile)
+ * INPUT:
+ * 	x0, y0	index of first window element in x and y direction (starting at 0, border included)
+ * 	nx, ny	number of window elements in x and y direction
+ * 	z		level index
+ * OUTPUT:
+ * 	returns window data as nx*ny float array (x is fastest varying)
+ */
+float *Geogrid::read_window(int x0, int y0, int nx, int ny, int z) {
+	if (!this->header_loaded) {
+		this->read_headerfile();
+	}
+
+	size_t ntx = this->header.tile_x+2*this->header.tile_bdr;
+	size_t nty = this->header.tile_y+2*this->header.tile_bdr;
+	size_t wsize = this->header.wordsize;
+
+	if (x0 < 0 or y0 < 0 or nx < 1 or ny < 1 or size_t(x0+nx) > ntx or size_t(y0+ny) > nty) {
+		cout << "ABORT: Window " << x0 << "," << y0 << "," << nx << "," << ny << " exceeds tile of " << ntx << "x" << nty << " elements!\n";
+		exit(EXIT_FAILURE);
+	}
+	if (z < 0 or z > this->header.tile_z-1) {
+		cout << "ABORT: Only level 0 to " << this->header.tile_z-1 << " found!\n";
+		exit(EXIT_FAILURE);
+	}
+
+	int fd = open(this->d_name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		cout << "Unable to load data file: " << this->d_name << endl;
+		exit(EXIT_FAILURE);
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 or size_t(st.st_size) != this->n_elem*wsize) {
+		close(fd);
+		cout << "ABORT: Number of elements in data file differs from numer indicated by index file : " << size_t(st.st_size) << " != " << this->n_elem*wsize << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	/* read rows of window (full width windows are read at once) */
+	size_t nrow = (size_t(nx) == ntx) ? ny : 1;
+	size_t nbytes = nrow*nx*wsize;
+	unsigned char *block = new unsigned char [nbytes];
+	float *win = (float *)malloc(sizeof(float)*nx*ny);
+
+	for (size_t j=0; j<size_t(ny); j+=nrow) {
+		off_t offset = off_t(((z*nty+y0+j)*ntx+x0)*wsize);
+		if (pread(fd, block, nbytes, offset) != ssize_t(nbytes)) {
+			close(fd);
+			cout << "ABORT: Problem reading window from data file: " << this->d_name << endl;
+			exit(EXIT_FAILURE);
+		}
+		if (wsize == 2) { /* decode whole block at once */
+			decode_n<ENDIAN_GEO>(block, (short *)block, nrow*nx);
+			for (size_t i=0; i<nrow*nx; i++) win[j*nx+i] = float(((short *)block)[i]);
+		} else {
+			for (size_t i=0; i<nrow*nx; i++) {
+				win[j*nx+i] = float(decode<ENDIAN_GEO,short>((char*)(&block[i*wsize])));
+			}
+		}
+	}
+
+	delete[] block;
+	close(fd);
+	return win;
+}
+
+/* constructor of Geogrid class
+ * (with load_data = false only the header is loaded, data can be read via read_window()) */
+Geogrid::Geogrid(string f, bool newfile, bool load_data) {
+	this->newfile = newfile;
+	this->load_data = load_data;
+	this->Init(f);
+}
+
 /* constructor of Geogrid class */
 Geogrid::Geogrid(string f, bool newfile) {
 	this->newfile = newfile;
+	this->load_data = true;
 	this->Init(f);
 }
 
 /* constructor of Geogrid class */
 Geogrid::Geogrid(string f) {
 	this->newfile = false;
+	this->load_data = true;
 	this->Init(f);
 }
 
@@ -211,8 +299,12 @@ void Geogrid::dump(int lvl) {
 
 	/* plot data if option was compiled */
 #ifdef QUICKPLOT_H_
-	size_t z_off = size_t(lvl)*(this->header.tile_y+2*this->header.tile_bdr)*(this->header.tile_x+2*this->header.tile_bdr);
-	QuickPlot(this->header.tile_y+2*this->header.tile_bdr, this->header.tile_x+2*this->header.tile_bdr, &this->data[z_off]);
+	int nx = this->header.tile_x+2*this->header.tile_bdr;
+	int ny = this->header.tile_y+2*this->header.tile_bdr;
+	size_t z_off = size_t(lvl)*ny*nx;
+	float zmin, zmax;
+	vec_minmax(size_t(nx)*ny, &this->data[z_off], &zmin, &zmax, true);
+	QuickPlot_xy(nx, ny, &this->data[z_off], zmin, zmax);
 #else
 	cout << "Plot option was not compiled!\n";
 #endif
@@ -297,10 +389,16 @@ void Geogrid::set_header(Geogrid *geo_in) {
 void Geogrid::data2mem(void) {
 	this->size = this->n_elem*this->header.wordsize;
 	this->memblock = new unsigned char [size_t(this->size)];
+	if (this->header.wordsize == 2) { /* encode whole block at once */
+		short *values = (short *)this->memblock;
+		for (size_t i=0; i<this->n_elem; i++) values[i] = short(this->data[i]);
+		encode_n<ENDIAN_GEO>(values, this->memblock, this->n_elem);
+		return;
+	}
 	size_t elem = 0;
 	unsigned char *b = (unsigned char *)malloc(sizeof(unsigned char)*this->header.wordsize);
 	for (size_t i=0; i<this->n_elem; i++) {
-		s2b(short(this->data[i]), (char *)b, true);
+		encode<ENDIAN_GEO>(short(this->data[i]), (char *)b);
 		for (size_t j=0; j<this->header.wordsize; j++) {
 			this->memblock[elem] = b[j];
 			elem++;
@@ -31,7 +31,7 @@ class Geogrid {
 	float *data; //loaded data as floats
 	streampos size; //number of Bytes in data file
 	unsigned char *memblock; //loaded data as Bytes
-	bool newfile, header_loaded, data_loaded;
+	bool newfile, load_data, header_loaded, data_loaded;
 
 	void Init (string); //initializes Geofile object
 	void read_headerfile(void); //loads header from geogrid index file
@@ -40,6 +40,7 @@ class Geogrid {
 
   public:
 	/* constructor and destructor */
+	Geogrid (string, bool, bool);
 	Geogrid (string, bool);
 	Geogrid (string);
    ~Geogrid (void); //close geogrid input file
@@ -49,6 +50,7 @@ class Geogrid {
    Geoheader *get_header(void); // returns header of current dataset
    size_t get_nelem(void); // returns numer of elements in current dataset
    float *get_data(void); // returns data of current dataset
+   float *read_window(int, int, int, int, int); // reads sub-window of one level directly from data file
 
    void dump(int); // dumps data of geogrid file
    void dump(void);
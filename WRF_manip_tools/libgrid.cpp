@@ -0,0 +1,452 @@
+/*
+ * libgrid.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Roman Finkelnburg
+ *   Copyright: Roman Finkelnburg (2026)
+ * Description: Grid point lookup and regridding for curvilinear lat/lon grids
+ *              (e.g. WRF XLAT/XLONG) used by WRF_manip_tools.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <math.h>
+#include "libutils.h"
+#include "libgrid.h"
+
+/* converts lat/lon in degrees into unit vector */
+void latlon2xyz(double lat, double lon, double *v) {
+	double rlat = lat*M_PI/180.0, rlon = lon*M_PI/180.0;
+	v[0] = cos(rlat)*cos(rlon);
+	v[1] = cos(rlat)*sin(rlon);
+	v[2] = sin(rlat);
+}
+
+/* converts vector into lat/lon in degrees */
+void xyz2latlon(const double *v, double *lat, double *lon) {
+	*lat = atan2(v[2], sqrt(v[0]*v[0]+v[1]*v[1]))*180.0/M_PI;
+	*lon = atan2(v[1], v[0])*180.0/M_PI;
+}
+
+/* great circle distance in km of two lat/lon positions in degrees (haversine formula) */
+double great_circle(double lat1, double lon1, double lat2, double lon2) {
+	double dlat = (lat2-lat1)*M_PI/180.0, dlon = (lon2-lon1)*M_PI/180.0;
+	double a = sin(dlat/2)*sin(dlat/2)+cos(lat1*M_PI/180.0)*cos(lat2*M_PI/180.0)*sin(dlon/2)*sin(dlon/2);
+	return 2*EARTH_RADIUS_KM*asin(min(1.0, sqrt(a)));
+}
+
+/* FNV-1a hash of grid dimensions and lat/lon values */
+unsigned long long hash_grid(size_t nx, size_t ny, const float *lat, const float *lon) {
+	unsigned long long h = 14695981039346656037ULL;
+	unsigned long long dims[2] = {nx, ny};
+	const unsigned char *parts[3] = {(const unsigned char *)dims, (const unsigned char *)lat, (const unsigned char *)lon};
+	size_t lens[3] = {sizeof(dims), nx*ny*sizeof(float), nx*ny*sizeof(float)};
+	for (int k=0; k<3; k++) {
+		for (size_t b=0; b<lens[k]; b++) {
+			h ^= parts[k][b];
+			h *= 1099511628211ULL;
+		}
+	}
+	return h;
+}
+
+/**************
+ * grid index *
+ **************/
+
+GridIndex::GridIndex(size_t nx, size_t ny, const float *lat, const float *lon) : n_x(nx), n_y(ny) {
+	this->init(lat, lon);
+	this->build(0, this->tree.size());
+}
+
+GridIndex::GridIndex(size_t nx, size_t ny, const float *lat, const float *lon, string cachedir) : n_x(nx), n_y(ny) {
+	this->init(lat, lon);
+	if (cachedir.empty()) {
+		this->build(0, this->tree.size());
+		return;
+	}
+	char name[32];
+	snprintf(name, sizeof(name), "grid_%016llx.idx", this->grid_hash);
+	string path = cachedir+"/"+name;
+	if (this->load(path)) return;
+	this->build(0, this->tree.size());
+	this->save(path);
+}
+
+/* sets unit vectors and hash of grid */
+void GridIndex::init(const float *lat, const float *lon) {
+	size_t n = this->n_x*this->n_y;
+	if (n == 0) {
+		cout << "ABORT: Empty grid can not be indexed!\n";
+		exit(EXIT_FAILURE);
+	}
+	this->from_cache = false;
+	this->grid_hash = hash_grid(this->n_x, this->n_y, lat, lon);
+	this->xyz.resize(3*n);
+	this->tree.resize(n);
+	this->axis.resize(n);
+	for (size_t p=0; p<n; p++) {
+		latlon2xyz(lat[p], lon[p], &this->xyz[3*p]);
+		this->tree[p] = p;
+	}
+}
+
+/* loads tree of cache file (false: no valid cache of this grid) */
+bool GridIndex::load(string path) {
+	ifstream ifile(path.c_str(), ios::binary);
+	if (!ifile.is_open()) return false;
+	char magic[8];
+	unsigned long long head[3];
+	ifile.read(magic, sizeof(magic));
+	ifile.read((char *)head, sizeof(head));
+	if (!ifile.good() or memcmp(magic, "GRIDIDX1", 8) or head[0] != this->grid_hash
+			or head[1] != this->n_x or head[2] != this->n_y) return false;
+
+	size_t n = this->tree.size();
+	vector<unsigned long long> t(n);
+	ifile.read((char *)&t[0], n*sizeof(unsigned long long));
+	ifile.read((char *)&this->axis[0], n);
+	if (!ifile.good()) return false;
+	for (size_t k=0; k<n; k++) {
+		if (t[k] >= n or this->axis[k] > 2) return false;
+		this->tree[k] = t[k];
+	}
+	this->from_cache = true;
+	return true;
+}
+
+/* stores tree in cache file */
+void GridIndex::save(string path) const {
+	size_t n = this->tree.size();
+	unsigned long long head[3] = {this->grid_hash, this->n_x, this->n_y};
+	vector<unsigned long long> t(this->tree.begin(), this->tree.end());
+	bool ok = write_atomic(path, [&](ofstream &ofile) {
+		ofile.write("GRIDIDX1", 8);
+		ofile.write((const char *)head, sizeof(head));
+		ofile.write((const char *)&t[0], n*sizeof(unsigned long long));
+		ofile.write((const char *)&this->axis[0], n);
+		return true;
+	});
+	if (!ok) cout << "WARNING: Cannot write grid index cache " << path << "\n";
+}
+
+/* builds subtree of range [lo,hi) splitting at median of axis with largest extent */
+void GridIndex::build(size_t lo, size_t hi) {
+	if (hi-lo <= 1) return;
+	double vmin[3] = {HUGE_VAL, HUGE_VAL, HUGE_VAL}, vmax[3] = {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+	for (size_t k=lo; k<hi; k++) {
+		const double *v = &this->xyz[3*this->tree[k]];
+		for (int a=0; a<3; a++) {
+			vmin[a] = min(vmin[a], v[a]);
+			vmax[a] = max(vmax[a], v[a]);
+		}
+	}
+	int ax = 0;
+	for (int a=1; a<3; a++) if (vmax[a]-vmin[a] > vmax[ax]-vmin[ax]) ax = a;
+
+	size_t mid = lo+(hi-lo)/2;
+	const vector<double> &xyz = this->xyz;
+	nth_element(this->tree.begin()+lo, this->tree.begin()+mid, this->tree.begin()+hi,
+			[&](size_t p, size_t q) { return xyz[3*p+ax] < xyz[3*q+ax]; });
+	this->axis[mid] = ax;
+	this->build(lo, mid);
+	this->build(mid+1, hi);
+}
+
+/* searches range [lo,hi) for point closest to q (squared chord length in bestd) */
+void GridIndex::search(size_t lo, size_t hi, const double *q, size_t *best, double *bestd) const {
+	if (lo >= hi) return;
+	size_t mid = lo+(hi-lo)/2;
+	size_t p = this->tree[mid];
+	const double *v = &this->xyz[3*p];
+	double d = (v[0]-q[0])*(v[0]-q[0])+(v[1]-q[1])*(v[1]-q[1])+(v[2]-q[2])*(v[2]-q[2]);
+	if (d < *bestd or (d == *bestd and p < *best)) {
+		*bestd = d;
+		*best = p;
+	}
+	if (hi-lo == 1) return;
+
+	int ax = this->axis[mid];
+	double diff = q[ax]-v[ax];
+	if (diff < 0) {
+		this->search(lo, mid, q, best, bestd);
+		if (diff*diff <= *bestd) this->search(mid+1, hi, q, best, bestd);
+	} else {
+		this->search(mid+1, hi, q, best, bestd);
+		if (diff*diff <= *bestd) this->search(lo, mid, q, best, bestd);
+	}
+}
+
+size_t GridIndex::nearest(double lat, double lon, double *dist) const {
+	double q[3];
+	latlon2xyz(lat, lon, q);
+	size_t best = 0;
+	double bestd = HUGE_VAL;
+	this->search(0, this->tree.size(), q, &best, &bestd);
+	if (dist) *dist = 2*EARTH_RADIUS_KM*asin(min(1.0, sqrt(bestd)/2)); /* chord to arc length */
+	return best;
+}
+
+void GridIndex::nearest(double lat, double lon, size_t *i, size_t *j, double *dist) const {
+	size_t p = this->nearest(lat, lon, dist);
+	*i = p%this->n_x;
+	*j = p/this->n_x;
+}
+
+/* bilinear weights of cell (i,j)-(i+1,j+1) if it encloses q (false otherwise).
+ * Corners are projected onto the tangent plane at q, where the bilinear mapping is inverted by Newton iteration. */
+bool GridIndex::cell_weights(const double *q, long i, long j, double *w) const {
+	if (i < 0 or j < 0 or i+1 >= long(this->n_x) or j+1 >= long(this->n_y)) return false;
+
+	/* orthonormal basis e1, e2 of tangent plane */
+	double k[3] = {0,0,1};
+	if (fabs(q[2]) > 0.9) { k[0] = 1; k[2] = 0; }
+	double e1[3] = {k[1]*q[2]-k[2]*q[1], k[2]*q[0]-k[0]*q[2], k[0]*q[1]-k[1]*q[0]};
+	double len = sqrt(e1[0]*e1[0]+e1[1]*e1[1]+e1[2]*e1[2]);
+	for (int a=0; a<3; a++) e1[a] /= len;
+	double e2[3] = {q[1]*e1[2]-q[2]*e1[1], q[2]*e1[0]-q[0]*e1[2], q[0]*e1[1]-q[1]*e1[0]};
+
+	double px[4], py[4];
+	size_t corner[4] = {j*this->n_x+i, j*this->n_x+i+1, (j+1)*this->n_x+i, (j+1)*this->n_x+i+1};
+	for (int c=0; c<4; c++) {
+		const double *v = &this->xyz[3*corner[c]];
+		if (v[0]*q[0]+v[1]*q[1]+v[2]*q[2] <= 0) return false; /* other hemisphere */
+		px[c] = v[0]*e1[0]+v[1]*e1[1]+v[2]*e1[2];
+		py[c] = v[0]*e2[0]+v[1]*e2[1]+v[2]*e2[2];
+	}
+
+	/* P(s,t) = p0 + a*s + b*t + c*s*t = 0 (q is origin of tangent plane) */
+	double ax = px[1]-px[0], ay = py[1]-py[0];
+	double bx = px[2]-px[0], by = py[2]-py[0];
+	double cx = px[0]-px[1]-px[2]+px[3], cy = py[0]-py[1]-py[2]+py[3];
+	double s = 0.5, t = 0.5;
+	for (int it=0; it<20; it++) {
+		double fx = px[0]+ax*s+bx*t+cx*s*t, fy = py[0]+ay*s+by*t+cy*s*t;
+		double j11 = ax+cx*t, j12 = bx+cx*s, j21 = ay+cy*t, j22 = by+cy*s;
+		double det = j11*j22-j12*j21;
+		if (det == 0) return false;
+		double ds = (fx*j22-fy*j12)/det, dt = (fy*j11-fx*j21)/det;
+		s -= ds;
+		t -= dt;
+		if (fabs(ds)+fabs(dt) < 1e-12) break;
+	}
+	const double eps = 1e-9;
+	if (!(s >= -eps and s <= 1+eps and t >= -eps and t <= 1+eps)) return false;
+	s = min(1.0, max(0.0, s));
+	t = min(1.0, max(0.0, t));
+	w[0] = (1-s)*(1-t);
+	w[1] = s*(1-t);
+	w[2] = (1-s)*t;
+	w[3] = s*t;
+	return true;
+}
+
+bool GridIndex::bilinear(double lat, double lon, GridWeights *gw) const {
+	if (this->n_x < 2 or this->n_y < 2) {
+		cout << "ABORT: Bilinear weights require at least 2x2 grid points!\n";
+		exit(EXIT_FAILURE);
+	}
+	double q[3];
+	latlon2xyz(lat, lon, q);
+	size_t i, j;
+	this->nearest(lat, lon, &i, &j);
+
+	/* enclosing cell shares a corner with nearest grid point */
+	for (long dj=0; dj>=-1; dj--) {
+		for (long di=0; di>=-1; di--) {
+			if (this->cell_weights(q, long(i)+di, long(j)+dj, gw->w)) {
+				gw->i = i+di;
+				gw->j = j+dj;
+				return true;
+			}
+		}
+	}
+
+	/* outside of grid: use nearest grid point */
+	gw->i = min(i, this->n_x-2);
+	gw->j = min(j, this->n_y-2);
+	for (int c=0; c<4; c++) gw->w[c] = 0;
+	gw->w[(i-gw->i)+2*(j-gw->j)] = 1;
+	return false;
+}
+
+/*****************
+ * sparse matrix *
+ *****************/
+
+SparseMatrix::SparseMatrix(size_t ncols) : n_cols(ncols), row_ptr(1, 0) {
+}
+
+void SparseMatrix::add_row(size_t n, const size_t *cols, const double *vals) {
+	for (size_t k=0; k<n; k++) {
+		if (cols[k] >= this->n_cols) {
+			cout << "ABORT: Column " << cols[k] << " exceeds sparse matrix of " << this->n_cols << " columns!\n";
+			exit(EXIT_FAILURE);
+		}
+		if (vals[k] == 0) continue;
+		this->col.push_back(cols[k]);
+		this->val.push_back(vals[k]);
+	}
+	this->row_ptr.push_back(this->col.size());
+}
+
+void SparseMatrix::apply(const float *x, float *y, int nthreads) const {
+	const size_t *rp = &this->row_ptr[0];
+	const unsigned int *c = this->col.empty() ? NULL : &this->col[0];
+	const float *v = this->val.empty() ? NULL : &this->val[0];
+	parallel_chunks(this->rows(), nthreads, size_t(1) << 14, [&](int chunk, size_t first, size_t last) {
+		for (size_t r=first; r<last; r++) {
+			float sum = 0;
+			for (size_t k=rp[r]; k<rp[r+1]; k++) sum += v[k]*x[c[k]];
+			y[r] = sum;
+		}
+	});
+}
+
+bool SparseMatrix::load(string path, unsigned long long key) {
+	ifstream ifile(path.c_str(), ios::binary);
+	if (!ifile.is_open()) return false;
+	char magic[8];
+	unsigned long long head[4];
+	ifile.read(magic, sizeof(magic));
+	ifile.read((char *)head, sizeof(head));
+	if (!ifile.good() or memcmp(magic, "SPARSEM1", 8) or head[0] != key) return false;
+
+	size_t nrows = head[1], nnz = head[3];
+	vector<unsigned long long> rp(nrows+1);
+	vector<unsigned int> c(nnz);
+	vector<float> v(nnz);
+	ifile.read((char *)&rp[0], rp.size()*sizeof(unsigned long long));
+	if (nnz > 0) {
+		ifile.read((char *)&c[0], nnz*sizeof(unsigned int));
+		ifile.read((char *)&v[0], nnz*sizeof(float));
+	}
+	if (!ifile.good() or rp[0] != 0 or rp[nrows] != nnz) return false;
+	for (size_t r=0; r<nrows; r++) if (rp[r] > rp[r+1]) return false;
+	for (size_t k=0; k<nnz; k++) if (c[k] >= head[2]) return false;
+
+	this->n_cols = head[2];
+	this->row_ptr.assign(rp.begin(), rp.end());
+	this->col.swap(c);
+	this->val.swap(v);
+	return true;
+}
+
+void SparseMatrix::save(string path, unsigned long long key) const {
+	unsigned long long head[4] = {key, this->rows(), this->n_cols, this->nnz()};
+	vector<unsigned long long> rp(this->row_ptr.begin(), this->row_ptr.end());
+	bool ok = write_atomic(path, [&](ofstream &ofile) {
+		ofile.write("SPARSEM1", 8);
+		ofile.write((const char *)head, sizeof(head));
+		ofile.write((const char *)&rp[0], rp.size()*sizeof(unsigned long long));
+		if (this->nnz() > 0) {
+			ofile.write((const char *)&this->col[0], this->nnz()*sizeof(unsigned int));
+			ofile.write((const char *)&this->val[0], this->nnz()*sizeof(float));
+		}
+		return true;
+	});
+	if (!ok) cout << "WARNING: Cannot write sparse matrix " << path << "\n";
+}
+
+/**************
+ * regridding *
+ **************/
+
+/* position of fractional grid index (x,y) from bilinear interpolation of unit vectors of
+ * neighbouring grid points (extrapolated beyond the outer grid points) */
+static void grid_position(const vector<double> &xyz, size_t nx, size_t ny, double x, double y, double *v) {
+	long i = min(max(long(floor(x)), 0L), long(nx)-2);
+	long j = min(max(long(floor(y)), 0L), long(ny)-2);
+	double s = x-i, t = y-j;
+	double w[4] = {(1-s)*(1-t), s*(1-t), (1-s)*t, s*t};
+	size_t corner[4] = {j*nx+i, j*nx+i+1, (j+1)*nx+i, (j+1)*nx+i+1};
+	for (int a=0; a<3; a++) {
+		v[a] = 0;
+		for (int c=0; c<4; c++) v[a] += w[c]*xyz[3*corner[c]+a];
+	}
+}
+
+/* weights of target point p (conservative weights are the fractions of samples of the target cell
+ * nearest to each source point, i.e. falling into its cell) */
+static void regrid_row(const GridIndex &src, const vector<double> &xyz, size_t nx, size_t ny, size_t p,
+		RegridMethod method, vector<size_t> *cols, vector<double> *vals) {
+	cols->clear();
+	vals->clear();
+	if (method == REGRID_BILINEAR) {
+		double lat, lon;
+		xyz2latlon(&xyz[3*p], &lat, &lon);
+		GridWeights gw;
+		src.bilinear(lat, lon, &gw);
+		size_t snx = src.nx();
+		size_t corner[4] = {gw.j*snx+gw.i, gw.j*snx+gw.i+1, (gw.j+1)*snx+gw.i, (gw.j+1)*snx+gw.i+1};
+		for (int c=0; c<4; c++) {
+			cols->push_back(corner[c]);
+			vals->push_back(gw.w[c]);
+		}
+		return;
+	}
+
+	double x0 = double(p%nx)-0.5, y0 = double(p/nx)-0.5, d = 1.0/REGRID_SAMPLES;
+	double w = 1.0/(REGRID_SAMPLES*REGRID_SAMPLES);
+	for (int sy=0; sy<REGRID_SAMPLES; sy++) {
+		for (int sx=0; sx<REGRID_SAMPLES; sx++) {
+			double v[3], lat, lon;
+			grid_position(xyz, nx, ny, x0+(sx+0.5)*d, y0+(sy+0.5)*d, v);
+			xyz2latlon(v, &lat, &lon);
+			size_t q = src.nearest(lat, lon);
+			size_t k = 0;
+			while (k < cols->size() and (*cols)[k] != q) k++;
+			if (k == cols->size()) {
+				cols->push_back(q);
+				vals->push_back(0);
+			}
+			(*vals)[k] += w;
+		}
+	}
+}
+
+SparseMatrix regrid_weights(const GridIndex &src, size_t nx, size_t ny, const float *lat, const float *lon,
+		RegridMethod method, string cachedir) {
+	if (nx < 2 or ny < 2) {
+		cout << "ABORT: Regridding requires a target grid of at least 2x2 points!\n";
+		exit(EXIT_FAILURE);
+	}
+	if (src.nx()*src.ny() > 0xFFFFFFFFUL) {
+		cout << "ABORT: Source grid of " << src.nx() << "x" << src.ny() << " points too large for regridding!\n";
+		exit(EXIT_FAILURE);
+	}
+
+	/* cache file of weights is keyed by source grid, target grid and method */
+	unsigned long long key = src.hash();
+	unsigned long long tgt = hash_grid(nx, ny, lat, lon);
+	int m = method;
+	key = hash_bytes(&tgt, sizeof(tgt), key);
+	key = hash_bytes(&m, sizeof(m), key);
+	string path;
+	if (!cachedir.empty()) {
+		char name[40];
+		snprintf(name, sizeof(name), "regrid_%016llx.csr", key);
+		path = cachedir+"/"+name;
+		SparseMatrix cached;
+		if (cached.load(path, key) and cached.rows() == nx*ny and cached.cols() == src.nx()*src.ny()) return cached;
+	}
+
+	/* rows are computed in parallel and appended in order */
+	size_t n = nx*ny;
+	vector<double> xyz(3*n);
+	for (size_t p=0; p<n; p++) latlon2xyz(lat[p], lon[p], &xyz[3*p]);
+	vector< vector<size_t> > cols(n);
+	vector< vector<double> > vals(n);
+	parallel_chunks(n, 0, 256, [&](int chunk, size_t first, size_t last) {
+		for (size_t p=first; p<last; p++) regrid_row(src, xyz, nx, ny, p, method, &cols[p], &vals[p]);
+	});
+	SparseMatrix weights(src.nx()*src.ny());
+	for (size_t p=0; p<n; p++) weights.add_row(cols[p].size(), &cols[p][0], &vals[p][0]);
+
+	if (!path.empty()) weights.save(path, key);
+	return weights;
+}
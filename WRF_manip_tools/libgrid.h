@@ -0,0 +1,128 @@
+/*
+ * libgrid.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Roman Finkelnburg
+ *   Copyright: Roman Finkelnburg (2026)
+ * Description: Grid point lookup and regridding for curvilinear lat/lon grids
+ *              (e.g. WRF XLAT/XLONG) used by WRF_manip_tools.
+ */
+
+#ifndef LIBGRID_H_
+#define LIBGRID_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* mean earth radius in km */
+const double EARTH_RADIUS_KM = 6371.0;
+
+/* bilinear interpolation weights of the grid cell enclosing a position
+ * (w[0]: (i,j), w[1]: (i+1,j), w[2]: (i,j+1), w[3]: (i+1,j+1)) */
+struct GridWeights {
+	size_t i, j;
+	double w[4];
+};
+
+/* Index of the points of a curvilinear lat/lon grid. Points are stored as unit
+ * vectors in a balanced KD-tree (built once), so nearest neighbour queries take
+ * O(log n) and are not affected by the date line or the poles.
+ * The tree can be cached on disk keyed by the hash of the grid, so repeated runs on
+ * the same domain skip the build.
+ */
+class GridIndex {
+public:
+	/* lat/lon arrays of nx*ny values in degrees (x fastest varying) */
+	GridIndex(size_t nx, size_t ny, const float *lat, const float *lon);
+	/* same, tree is loaded from/stored into <cachedir>/grid_<hash>.idx (empty cachedir: no cache) */
+	GridIndex(size_t nx, size_t ny, const float *lat, const float *lon, string cachedir);
+
+	size_t nx() const { return n_x; }
+	size_t ny() const { return n_y; }
+
+	/* returns index j*nx+i of grid point nearest to lat/lon (dist: great circle distance in km) */
+	size_t nearest(double lat, double lon, double *dist = NULL) const;
+	void nearest(double lat, double lon, size_t *i, size_t *j, double *dist = NULL) const;
+	/* bilinear weights of the cell enclosing lat/lon (false: outside of grid, weights of nearest point are set) */
+	bool bilinear(double lat, double lon, GridWeights *gw) const;
+
+	unsigned long long hash() const { return grid_hash; }
+	bool cached() const { return from_cache; } /* tree was loaded from cache */
+
+private:
+	size_t n_x, n_y;
+	unsigned long long grid_hash;
+	bool from_cache;
+	vector<double> xyz;		/* unit vectors of grid points */
+	vector<size_t> tree;	/* point indices in KD-tree order (median of range is node) */
+	vector<unsigned char> axis;	/* split axis of node */
+
+	void init(const float *lat, const float *lon);
+	void build(size_t lo, size_t hi);
+	bool load(string path);
+	void save(string path) const;
+	bool cell_weights(const double *q, long i, long j, double *w) const;
+	void search(size_t lo, size_t hi, const double *q, size_t *best, double *bestd) const;
+};
+
+/* Sparse matrix in compressed sparse row format (e.g. regridding weights with one row per
+ * target point and one column per source point). Rows are appended in order, products are
+ * computed with rows split over threads.
+ */
+class SparseMatrix {
+public:
+	SparseMatrix(size_t ncols = 0);
+
+	size_t rows() const { return row_ptr.size()-1; }
+	size_t cols() const { return n_cols; }
+	size_t nnz() const { return col.size(); }
+
+	/* appends row of n values at columns cols */
+	void add_row(size_t n, const size_t *cols, const double *vals);
+	/* y = A x (x holds cols() values, y rows() values, nthreads <= 0: all cores) */
+	void apply(const float *x, float *y, int nthreads = 0) const;
+
+	/* loads matrix stored with key (false: no valid file) */
+	bool load(string path, unsigned long long key);
+	/* stores matrix */
+	void save(string path, unsigned long long key) const;
+
+private:
+	size_t n_cols;
+	vector<size_t> row_ptr;		/* first entry of row (rows()+1 values) */
+	vector<unsigned int> col;	/* column of entry */
+	vector<float> val;			/* value of entry */
+};
+
+/* regridding methods */
+enum RegridMethod {
+	REGRID_BILINEAR,		// bilinear interpolation within enclosing source cell
+	REGRID_CONSERVATIVE		// area weighted average of source cells overlapping target cell (first order)
+};
+
+/* number of samples per direction used to estimate overlaps of target and source cells */
+const int REGRID_SAMPLES = 5;
+
+/* weights mapping values of source grid onto target grid points lat/lon (nx*ny values in degrees,
+ * x fastest varying), i.e. target = W source. Target points outside of source grid take the nearest
+ * source value. Weights are loaded from/stored into <cachedir>/regrid_<hash>.csr (empty cachedir: no cache).
+ */
+SparseMatrix regrid_weights(const GridIndex &src, size_t nx, size_t ny, const float *lat, const float *lon,
+		RegridMethod method, string cachedir = "");
+
+/* FNV-1a hash of grid dimensions and lat/lon values */
+unsigned long long hash_grid(size_t nx, size_t ny, const float *lat, const float *lon);
+
+/* converts lat/lon in degrees into unit vector */
+void latlon2xyz(double lat, double lon, double *v);
+
+/* converts unit vector (or any non zero vector) into lat/lon in degrees */
+void xyz2latlon(const double *v, double *lat, double *lon);
+
+/* great circle distance in km of two lat/lon positions in degrees */
+double great_circle(double lat1, double lon1, double lat2, double lon2);
+
+#endif /* LIBGRID_H_ */
@@ -24,89 +24,97 @@ void write_str(ofstream *ofile, char *str, int len) {
 	ofile->write(str,len);
 }
 
-/* writes data set into Intermediate Format Files */
-int write_IFF(ofstream *ofile, bool endian, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, float **data) {
-	char dummy[4];
+/* writes value as word in byte order E */
+template <Endian E, typename T> inline void write_val(ofstream *ofile, T val) {
+	::byte b[sizeof(T)];
+	encode<E>(val, b);
+	ofile->write(b,sizeof(T));
+}
+
+/* writes data set into Intermediate Format Files using byte order E
+ * (data is a view on the nx*ny values of the record, x fastest varying) */
+template <Endian E>
+int write_IFF(ofstream *ofile, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, FieldSpan<const float> data) {
 
 	/****************************
 	 * write header information *
 	 ****************************/
 	/* write header version number (4 Bytes) */
-	i2b(4, dummy, endian); ofile->write(dummy,4); // 4 Byte block start
-	i2b(header.version, dummy, endian);ofile->write(dummy,4); // 4 Bytes
-	i2b(4, dummy, endian); ofile->write(dummy,4); // 4 Byte block end
+	write_val<E>(ofile, 4); // 4 Byte block start
+	write_val<E>(ofile, header.version); // 4 Bytes
+	write_val<E>(ofile, 4); // 4 Byte block end
 
 	/* write header (156 Bytes) */
-	i2b(156, dummy, endian); ofile->write(dummy,4); // 156 Byte block start
+	write_val<E>(ofile, 156); // 156 Byte block start
 	write_str(ofile, (char *)header.hdate,24); // 24 Bytes
-	f2b(header.xfcst, dummy, endian); ofile->write(dummy,4); // 4 Bytes
+	write_val<E>(ofile, header.xfcst); // 4 Bytes
 	write_str(ofile, (char *)header.map_source,32); // 32 Bytes
 	write_str(ofile, (char *)header.field,9); // 9 Bytes
 	write_str(ofile, (char *)header.units,25); // 25 Bytes
 	write_str(ofile, (char *)header.desc,46); // 46 Bytes
-	f2b(header.xlvl, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-	i2b(proj.nx, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-	i2b(proj.ny, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-	i2b(proj.iproj, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-	i2b(156, dummy, endian); ofile->write(dummy,4); // 156 Byte block end
+	write_val<E>(ofile, header.xlvl); // 4 Bytes
+	write_val<E>(ofile, proj.nx); // 4 Bytes
+	write_val<E>(ofile, proj.ny); // 4 Bytes
+	write_val<E>(ofile, proj.iproj); // 4 Bytes
+	write_val<E>(ofile, 156); // 156 Byte block end
 
 	/* write projection */
 	switch (proj.iproj) {
 	case 0 : /* Cylindrical equidistant */
-		i2b(28, dummy, endian); ofile->write(dummy,4); // 28 Byte block start
+		write_val<E>(ofile, 28); // 28 Byte block start
 		write_str(ofile, (char *)proj.startloc,8); // 8 Bytes
-		f2b(proj.startlat, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.startlon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.deltalat, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.deltalon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.earth_radius, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		i2b(28, dummy, endian); ofile->write(dummy,4); // 28 Byte block end
+		write_val<E>(ofile, proj.startlat); // 4 Bytes
+		write_val<E>(ofile, proj.startlon); // 4 Bytes
+		write_val<E>(ofile, proj.deltalat); // 4 Bytes
+		write_val<E>(ofile, proj.deltalon); // 4 Bytes
+		write_val<E>(ofile, proj.earth_radius); // 4 Bytes
+		write_val<E>(ofile, 28); // 28 Byte block end
 		break;
 	case 1 : /* Mercator */
-		i2b(32, dummy, endian); ofile->write(dummy,4); // 32 Byte block start
+		write_val<E>(ofile, 32); // 32 Byte block start
 		write_str(ofile, (char *)proj.startloc,8); // 8 Bytes
-		f2b(proj.startlat, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.startlon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.dx, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.dy, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.truelat1, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.earth_radius, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		i2b(32, dummy, endian); ofile->write(dummy,4); // 32 Byte block end
+		write_val<E>(ofile, proj.startlat); // 4 Bytes
+		write_val<E>(ofile, proj.startlon); // 4 Bytes
+		write_val<E>(ofile, proj.dx); // 4 Bytes
+		write_val<E>(ofile, proj.dy); // 4 Bytes
+		write_val<E>(ofile, proj.truelat1); // 4 Bytes
+		write_val<E>(ofile, proj.earth_radius); // 4 Bytes
+		write_val<E>(ofile, 32); // 32 Byte block end
 		break;
 	case 3 : /* Lambert conformal */
-		i2b(40, dummy, endian); ofile->write(dummy,4); // 40 Byte block start
+		write_val<E>(ofile, 40); // 40 Byte block start
 		write_str(ofile, (char *)proj.startloc,8); // 8 Bytes
-		f2b(proj.startlat, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.startlon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.dx, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.dy, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.xlonc, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.truelat1, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.truelat2, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.earth_radius, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		i2b(40, dummy, endian); ofile->write(dummy,4); // 40 Byte block end
+		write_val<E>(ofile, proj.startlat); // 4 Bytes
+		write_val<E>(ofile, proj.startlon); // 4 Bytes
+		write_val<E>(ofile, proj.dx); // 4 Bytes
+		write_val<E>(ofile, proj.dy); // 4 Bytes
+		write_val<E>(ofile, proj.xlonc); // 4 Bytes
+		write_val<E>(ofile, proj.truelat1); // 4 Bytes
+		write_val<E>(ofile, proj.truelat2); // 4 Bytes
+		write_val<E>(ofile, proj.earth_radius); // 4 Bytes
+		write_val<E>(ofile, 40); // 40 Byte block end
 		break;
 	case 4 : /* Gaussian */
-		i2b(28, dummy, endian); ofile->write(dummy,4); // 28 Byte block start
+		write_val<E>(ofile, 28); // 28 Byte block start
 		write_str(ofile, (char *)proj.startloc,8); // 8 Bytes
-		f2b(proj.startlat, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.startlon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.nlats, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.deltalon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.earth_radius, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		i2b(28, dummy, endian); ofile->write(dummy,4); // 28 Byte block end
+		write_val<E>(ofile, proj.startlat); // 4 Bytes
+		write_val<E>(ofile, proj.startlon); // 4 Bytes
+		write_val<E>(ofile, proj.nlats); // 4 Bytes
+		write_val<E>(ofile, proj.deltalon); // 4 Bytes
+		write_val<E>(ofile, proj.earth_radius); // 4 Bytes
+		write_val<E>(ofile, 28); // 28 Byte block end
 		break;
 	case 5 : /* Polar stereographic */
-		i2b(36, dummy, endian); ofile->write(dummy,4); // 36 Byte block start
+		write_val<E>(ofile, 36); // 36 Byte block start
 		write_str(ofile, (char *)proj.startloc,8); // 8 Bytes
-		f2b(proj.startlat, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.startlon, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.dx, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.dy, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.xlonc, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.truelat1, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		f2b(proj.earth_radius, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		i2b(36, dummy, endian); ofile->write(dummy,4); // 36 Byte block end
+		write_val<E>(ofile, proj.startlat); // 4 Bytes
+		write_val<E>(ofile, proj.startlon); // 4 Bytes
+		write_val<E>(ofile, proj.dx); // 4 Bytes
+		write_val<E>(ofile, proj.dy); // 4 Bytes
+		write_val<E>(ofile, proj.xlonc); // 4 Bytes
+		write_val<E>(ofile, proj.truelat1); // 4 Bytes
+		write_val<E>(ofile, proj.earth_radius); // 4 Bytes
+		write_val<E>(ofile, 36); // 36 Byte block end
 		break;
 	default:
 		cout << "Projection unknown!\n";
@@ -114,23 +122,51 @@ int write_IFF(ofstream *ofile, bool endian, struct IFFheader header, struct IFFp
 	}
 
 	/* write wind grid info */
-	i2b(4, dummy, endian); ofile->write(dummy,4); // 4 Byte block start
-	i2b(is_wind_grid_rel, dummy, endian); ofile->write(dummy,4); // 4 Bytes
-	i2b(4, dummy, endian); ofile->write(dummy,4); // 4 Byte block end
-
-	/* write data */
-	int cnt = proj.nx*proj.ny*4;
-	i2b(cnt, dummy, endian); ofile->write(dummy,4); // data block start
-	for (int j=0; j<proj.ny; j++) {
-		for (int i=0; i<proj.nx; i++) {
-			f2b(data[i][j], dummy, endian); ofile->write(dummy,4); // 4 Bytes
-		}
+	write_val<E>(ofile, 4); // 4 Byte block start
+	write_val<E>(ofile, is_wind_grid_rel); // 4 Bytes
+	write_val<E>(ofile, 4); // 4 Byte block end
+
+	/* write data (values are in IFF order, so contiguous views are written as one block) */
+	if (data.size() != size_t(proj.nx)*size_t(proj.ny)) {
+		cout << "ABORT: Record of " << data.size() << " values does not match projection " << proj.nx << "x" << proj.ny << "!\n";
+		return EXIT_FAILURE;
+	}
+	int cnt = data.size()*sizeof(float);
+	write_val<E>(ofile, cnt); // data block start
+	if (E == ENDIAN_HOST and data.contiguous()) {
+		ofile->write((const char *)data.data(),cnt); // nx*ny*4 Bytes
+	} else {
+		Field2D<float> block(proj.nx, proj.ny, &buffer_pool());
+		data.copy_to(block.data()); /* gathers strided views */
+		encode_n<E>(block.data(), block.data(), block.size());
+		ofile->write((const char *)block.data(),cnt); // nx*ny*4 Bytes
 	}
-	i2b(cnt, dummy, endian); ofile->write(dummy,4); // data block end
+	write_val<E>(ofile, cnt); // data block end
 
 	return EXIT_SUCCESS;
 }
 
+template <Endian E>
+int write_IFF(ofstream *ofile, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, const Field2D<float> &data) {
+	if (data.nx() != size_t(proj.nx) or data.ny() != size_t(proj.ny)) {
+		cout << "ABORT: Field dimensions " << data.nx() << "x" << data.ny() << " do not match projection " << proj.nx << "x" << proj.ny << "!\n";
+		return EXIT_FAILURE;
+	}
+	return write_IFF<E>(ofile, header, proj, is_wind_grid_rel, data.span());
+}
+
+template int write_IFF<ENDIAN_LITTLE>(ofstream *, struct IFFheader, struct IFFproj, int, FieldSpan<const float>);
+template int write_IFF<ENDIAN_BIG>(ofstream *, struct IFFheader, struct IFFproj, int, FieldSpan<const float>);
+template int write_IFF<ENDIAN_LITTLE>(ofstream *, struct IFFheader, struct IFFproj, int, const Field2D<float> &);
+template int write_IFF<ENDIAN_BIG>(ofstream *, struct IFFheader, struct IFFproj, int, const Field2D<float> &);
+
+/* writes data set into Intermediate Format Files
+ * (endian = true writes big endian IFF as expected by WPS, false writes host byte order) */
+int write_IFF(ofstream *ofile, bool endian, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, const Field2D<float> &data) {
+	if (endian) return write_IFF<ENDIAN_BIG>(ofile, header, proj, is_wind_grid_rel, data);
+	return write_IFF<ENDIAN_HOST>(ofile, header, proj, is_wind_grid_rel, data);
+}
+
 /* writes a record into open IFF
  * INPUT:
  *  ofile		pointer to IFF
@@ -141,19 +177,15 @@ int write_IFF(ofstream *ofile, bool endian, struct IFFheader header, struct IFFp
  *  xlvl		pressure level
  *  Time		WRF time variable
  *  t_idx		time step index
- *  p_idx		pressure level index
- *  n_plvl		number of pressure levels in value array
  *  field		variable name
  *  units		variable unit
  *  dec			variable description
- *  values		variable values
+ *  values		view on the proj.nx*proj.ny record values (may be strided, e.g. one layer of a slab)
  */
 int write_IFF_record(ofstream *ofile, IFFproj proj, string mapsource,
-		int version, float xfcst, float xlvl, void *Time, long t_idx, long p_idx, long n_plvl,
-		string field, string units, string desc, void* values) {
-	bool endian = true;
+		int version, float xfcst, float xlvl, void *Time, long t_idx,
+		string field, string units, string desc, FieldSpan<const float> values) {
 	int is_wind_grid_rel = 0;
-	float **data = allocate2D(proj.nx, proj.ny);
 
 	IFFheader header;
 	header.version = version;
@@ -165,16 +197,36 @@ int write_IFF_record(ofstream *ofile, IFFproj proj, string mapsource,
 	cp_string(header.units, 26, units.c_str(), units.size());
 	cp_string(header.desc, 47, desc.c_str(), desc.size());
 
-	/* transform data for IFF writing */
-	for (long j=0; j<proj.ny; j++) // south_north dimension loop
-		for (long k=0; k<proj.nx; k++) // west_east dimension loop
-			data[k][j] = ((float *) values)[t_idx*(n_plvl*proj.ny*proj.nx)+p_idx*(proj.ny*proj.nx)+j*proj.nx+k];
-
-	/* write record to file */
-	if (write_IFF(ofile, endian, header, proj, is_wind_grid_rel, data)) {
+	/* write record to file (directly from view, no copy) */
+	if (write_IFF<ENDIAN_IFF>(ofile, header, proj, is_wind_grid_rel, values)) {
 		cout << "ABORT: Problem writing " << header.hdate << ", " << header.field << ", " << header.xlvl << endl;
 		return EXIT_FAILURE;
 	}
 
 	return EXIT_SUCCESS;
 }
+
+/* writes a record into open IFF
+ * INPUT:
+ *  ofile		pointer to IFF
+ *  proj		projection information
+ *  mapsource	identifier of data origin
+ *  version		IFF version
+ *  xfcst		forcasting index
+ *  xlvl		pressure level
+ *  Time		WRF time variable
+ *  t_idx		time step index
+ *  p_idx		pressure level index
+ *  n_plvl		number of pressure levels in value array
+ *  field		variable name
+ *  units		variable unit
+ *  dec			variable description
+ *  values		variable values
+ */
+int write_IFF_record(ofstream *ofile, IFFproj proj, string mapsource,
+		int version, float xfcst, float xlvl, void *Time, long t_idx, long p_idx, long n_plvl,
+		string field, string units, string desc, void* values) {
+	size_t n = size_t(proj.ny)*size_t(proj.nx);
+	FieldSpan<const float> record(&((const float *) values)[(t_idx*n_plvl+p_idx)*n], n);
+	return write_IFF_record(ofile, proj, mapsource, version, xfcst, xlvl, Time, t_idx, field, units, desc, record);
+}
@@ -11,6 +11,8 @@
 #define LIBIFF_H_
 
 #include <fstream>
+#include "libutils.h"
+#include "libfield.h"
 
 using namespace std;
 
@@ -25,6 +27,9 @@ struct IFFheader {
 	float xlvl;
 };
 
+/* level code (xlvl) of surface fields */
+const float IFF_XLVL_SURFACE = 200100.0;
+
 struct IFFproj {
 	int iproj, nx, ny, nlats;
 	char startloc[9];
@@ -32,13 +37,31 @@ struct IFFproj {
 };
 
 /* writes data set into Intermediate Format Files */
-int write_IFF(ofstream *file, bool endian, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, float **data);
+int write_IFF(ofstream *file, bool endian, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, const Field2D<float> &data);
+
+/* writes data set into Intermediate Format Files using byte order E (instantiated for ENDIAN_LITTLE and ENDIAN_BIG) */
+template <Endian E>
+int write_IFF(ofstream *file, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, const Field2D<float> &data);
+template <Endian E>
+int write_IFF(ofstream *file, struct IFFheader header, struct IFFproj proj, int is_wind_grid_rel, FieldSpan<const float> data);
+
+/* reads value of type T stored in byte order E from IFF */
+template <Endian E, typename T> inline T read_IFF_value(ifstream *file) {
+	::byte b[sizeof(T)];
+	file->read(b,sizeof(T));
+	return decode<E,T>(b);
+}
 
 /* writes a record into open IFF */
 int write_IFF_record(ofstream *ofile, IFFproj proj, string mapsource,
 		int version, float xfcst, float xlvl, void *Time, long t_idx, long p_idx, long n_plvl,
 		string field, string units, string desc, void* values);
 
+/* writes a record from (strided) view on its values into open IFF */
+int write_IFF_record(ofstream *ofile, IFFproj proj, string mapsource,
+		int version, float xfcst, float xlvl, void *Time, long t_idx,
+		string field, string units, string desc, FieldSpan<const float> values);
+
 
 
 
@@ -12,12 +12,25 @@
 #include <cstring>
 #include <iostream>
 #include <math.h>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <poll.h>
 #include "libutils.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
 /* converts 2 Byte array into integer */
 short b2s(char b[2], bool endian) {
 	union {
-	        byte bytes[2];
+	        ::byte bytes[2];
 	        short i;
 	} un1;
 
@@ -34,7 +47,7 @@ short b2s(char b[2], bool endian) {
 /* converts integer into 2 Byte array */
 void s2b(short i, char b[2], bool endian) {
 	union {
-	        byte bytes[2];
+	        ::byte bytes[2];
 	        short i;
 	} un1;
 
@@ -52,7 +65,7 @@ void s2b(short i, char b[2], bool endian) {
 /* converts 4 Byte array into integer */
 int b2i(char b[4], bool endian) {
 	union {
-	        byte bytes[4];
+	        ::byte bytes[4];
 	        int i;
 	} un1;
 
@@ -73,7 +86,7 @@ int b2i(char b[4], bool endian) {
 /* converts integer into 4 Byte array */
 void i2b(int i, char b[4], bool endian) {
 	union {
-	        byte bytes[4];
+	        ::byte bytes[4];
 	        int i;
 	} un1;
 
@@ -142,9 +155,9 @@ float b2f(char b[4], bool endian) {
 /* converts float into Byte array */
 void f2b(float f, char *b, bool endian, int n) {
 	union {
-		byte b;
-		byte b2[2];
-		byte b4[4];
+		::byte b;
+		::byte b2[2];
+		::byte b4[4];
 		float f;
 	} un1;
 
@@ -188,26 +201,267 @@ void f2b(float f, char b[4], bool endian) {
 	f2b(f,b,endian,4);
 }
 
-/* allocates a 2D float array */
-float** allocate2D(int ncols, int nrows) {
-  int i;
-  float **dat2;
-  /*  allocate array of pointers  */
-  dat2 = (float**)malloc(ncols*sizeof(float*));
-
-  if(dat2==NULL) {
-    printf("\nError allocating memory\n");
-    exit(1);
-  }
-  /*  allocate each row  */
-  for(i = 0; i < ncols; i++) {
-    dat2[i] = (float*)malloc( nrows*sizeof(float));
-  }
-  if(dat2[i-1]==NULL) {
-    printf("\nError allocating memory\n");
-    exit(1);
-  }
-  return dat2;
+/**********************
+ * bulk byte swapping *
+ **********************/
+
+/* shuffle patterns reversing the bytes of each 2, 4 and 8 Byte value in a 16 Byte block */
+static const char bswap_pattern16[16] = {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14};
+static const char bswap_pattern32[16] = {3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12};
+static const char bswap_pattern64[16] = {7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8};
+
+/* swaps bytes of whole 16 Byte blocks, returns number of processed Bytes */
+static size_t bswap_block_none(const char *src, char *dst, size_t nbytes, const char *pattern) {
+	return 0;
+}
+
+#ifdef SIMD_X86
+__attribute__((target("ssse3")))
+static size_t bswap_block_ssse3(const char *src, char *dst, size_t nbytes, const char *pattern) {
+	__m128i mask = _mm_loadu_si128((const __m128i *)pattern);
+	size_t i = 0;
+	for (; i+16 <= nbytes; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src+i));
+		_mm_storeu_si128((__m128i *)(dst+i), _mm_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t bswap_block_avx2(const char *src, char *dst, size_t nbytes, const char *pattern) {
+	__m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)pattern));
+	size_t i = 0;
+	for (; i+64 <= nbytes; i += 64) {
+		__m256i v0 = _mm256_loadu_si256((const __m256i *)(src+i));
+		__m256i v1 = _mm256_loadu_si256((const __m256i *)(src+i+32));
+		_mm256_storeu_si256((__m256i *)(dst+i), _mm256_shuffle_epi8(v0, mask));
+		_mm256_storeu_si256((__m256i *)(dst+i+32), _mm256_shuffle_epi8(v1, mask));
+	}
+	for (; i+32 <= nbytes; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src+i));
+		_mm256_storeu_si256((__m256i *)(dst+i), _mm256_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+#endif
+
+/* selects block kernel supported by current CPU */
+typedef size_t (*bswap_block_fcn)(const char *, char *, size_t, const char *);
+
+static bswap_block_fcn bswap_block_select(void) {
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return bswap_block_avx2;
+	if (__builtin_cpu_supports("ssse3")) return bswap_block_ssse3;
+#endif
+	return bswap_block_none;
+}
+
+static size_t bswap_block(const void *src, void *dst, size_t nbytes, const char *pattern) {
+	static bswap_block_fcn fcn = bswap_block_select();
+	return fcn((const char *)src, (char *)dst, nbytes, pattern);
+}
+
+/* byte-swaps array of n 2 Byte values */
+void bswap16_n(const void *src, void *dst, size_t n) {
+	size_t i = bswap_block(src, dst, n*2, bswap_pattern16)/2;
+	for (; i<n; i++) {
+		unsigned short v;
+		memcpy(&v, (const char *)src+i*2, 2);
+		v = __builtin_bswap16(v);
+		memcpy((char *)dst+i*2, &v, 2);
+	}
+}
+
+/* byte-swaps array of n 4 Byte values */
+void bswap32_n(const void *src, void *dst, size_t n) {
+	size_t i = bswap_block(src, dst, n*4, bswap_pattern32)/4;
+	for (; i<n; i++) {
+		unsigned int v;
+		memcpy(&v, (const char *)src+i*4, 4);
+		v = __builtin_bswap32(v);
+		memcpy((char *)dst+i*4, &v, 4);
+	}
+}
+
+/* byte-swaps array of n 8 Byte values */
+void bswap64_n(const void *src, void *dst, size_t n) {
+	size_t i = bswap_block(src, dst, n*8, bswap_pattern64)/8;
+	for (; i<n; i++) {
+		unsigned long long v;
+		memcpy(&v, (const char *)src+i*8, 8);
+		v = __builtin_bswap64(v);
+		memcpy((char *)dst+i*8, &v, 8);
+	}
+}
+
+void bswap16_n(void *buf, size_t n) {
+	bswap16_n((const void *)buf, buf, n);
+}
+
+void bswap32_n(void *buf, size_t n) {
+	bswap32_n((const void *)buf, buf, n);
+}
+
+void bswap64_n(void *buf, size_t n) {
+	bswap64_n((const void *)buf, buf, n);
+}
+
+/***************
+ * buffer pool *
+ ***************/
+
+/* header in front of each pooled buffer (one alignment unit) */
+struct BufferPool::Block {
+	Block *next, *prev;
+	size_t cls, size, used;
+	char pad[64-2*sizeof(Block *)-3*sizeof(size_t)];
+};
+
+/* returns size class of buffer with given size and size of that class */
+static int pool_class(size_t bytes, size_t *csize) {
+	if (bytes <= 64) {
+		*csize = 64;
+		return 0;
+	}
+	int k = 63-__builtin_clzll((unsigned long long)bytes); // 2^k <= bytes < 2^(k+1)
+	size_t base = size_t(1) << k;
+	size_t step = base >> 2;
+	size_t q = (bytes-base+step-1)/step; // 0..4
+	*csize = base+q*step;
+	return (k-6)*4+int(q);
+}
+
+BufferPool::BufferPool() : used_list(NULL), n_alloc(0), n_acquire(0), n_used(0), n_reserved(0) {
+	for (int i=0; i<NCLASS; i++) free_list[i] = NULL;
+}
+
+BufferPool::~BufferPool() {
+	this->reset();
+	this->purge();
+}
+
+void *BufferPool::acquire(size_t bytes) {
+	size_t csize;
+	int cls = pool_class(bytes, &csize);
+	lock_guard<mutex> guard(this->lock);
+
+	Block *b = this->free_list[cls];
+	if (b) { /* reuse cached buffer */
+		this->free_list[cls] = b->next;
+	} else { /* allocate new buffer */
+		void *p = NULL;
+		if (posix_memalign(&p, sizeof(Block), sizeof(Block)+csize) != 0) {
+			cout << "ABORT: Error allocating buffer of " << csize << " Bytes!\n";
+			exit(EXIT_FAILURE);
+		}
+		b = (Block *)p;
+		b->cls = cls;
+		b->size = csize;
+		this->n_alloc++;
+		this->n_reserved += csize;
+	}
+
+	/* link into list of buffers in use */
+	b->used = 1;
+	b->prev = NULL;
+	b->next = this->used_list;
+	if (this->used_list) this->used_list->prev = b;
+	this->used_list = b;
+	this->n_acquire++;
+	this->n_used++;
+	return (void *)(b+1);
+}
+
+void BufferPool::release(void *ptr) {
+	if (ptr == NULL) return;
+	Block *b = ((Block *)ptr)-1;
+	lock_guard<mutex> guard(this->lock);
+	if (!b->used) return; /* already returned by reset() */
+
+	/* unlink from list of buffers in use */
+	if (b->prev) b->prev->next = b->next;
+	else this->used_list = b->next;
+	if (b->next) b->next->prev = b->prev;
+
+	b->used = 0;
+	b->next = this->free_list[b->cls];
+	this->free_list[b->cls] = b;
+	this->n_used--;
+}
+
+void BufferPool::reset(void) {
+	lock_guard<mutex> guard(this->lock);
+	while (this->used_list) {
+		Block *b = this->used_list;
+		this->used_list = b->next;
+		b->used = 0;
+		b->next = this->free_list[b->cls];
+		this->free_list[b->cls] = b;
+	}
+	this->n_used = 0;
+}
+
+void BufferPool::purge(void) {
+	lock_guard<mutex> guard(this->lock);
+	for (int i=0; i<NCLASS; i++) {
+		while (this->free_list[i]) {
+			Block *b = this->free_list[i];
+			this->free_list[i] = b->next;
+			this->n_reserved -= b->size;
+			free(b);
+		}
+	}
+}
+
+void BufferPool::print_stats(string name) {
+	cout << name << ": " << this->n_alloc << " allocations, " << this->reuses() << " reuses, "
+		 << this->n_used << " in use, " << this->n_reserved/(1024.0*1024.0) << " MB reserved\n";
+}
+
+/* process wide buffer pool */
+BufferPool &buffer_pool(void) {
+	static BufferPool pool;
+	return pool;
+}
+
+/****************
+ * block writer *
+ ****************/
+
+BlockWriter::BlockWriter(FILE *out, size_t size) : out(out) {
+	if (size < 64) size = 64;
+	this->block = (char *)malloc(size);
+	if (this->block == NULL) {
+		cout << "ABORT: Error allocating output buffer!\n";
+		exit(EXIT_FAILURE);
+	}
+	this->pos = this->block;
+	this->end = this->block+size;
+}
+
+BlockWriter::~BlockWriter() {
+	this->flush();
+	free(this->block);
+}
+
+void BlockWriter::put(const char *s, size_t n) {
+	while (n > 0) {
+		if (this->pos == this->end) this->flush();
+		size_t m = min(n, size_t(this->end-this->pos));
+		memcpy(this->pos, s, m);
+		this->pos += m;
+		s += m;
+		n -= m;
+	}
+}
+
+/* writes collected output */
+void BlockWriter::flush(void) {
+	fflush(stdout); /* keep order with printf/cout output */
+	if (this->pos > this->block) fwrite(this->block, 1, this->pos-this->block, this->out);
+	fflush(this->out);
+	this->pos = this->block;
 }
 
 /* copies char pointer cstr into char pointer str */
@@ -245,8 +499,352 @@ string time2str(void* ch, int n) {
     return tstr;
 }
 
+/* FNV-1a hash of len Bytes at data */
+unsigned long long hash_bytes(const void *data, size_t len, unsigned long long h) {
+	const unsigned char *b = (const unsigned char *)data;
+	for (size_t i=0; i<len; i++) {
+		h ^= b[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/* CRC-32 of len Bytes at data (reflected polynomial 0xEDB88320, table built once on first call) */
+unsigned long calc_crc32(const void *data, size_t len, unsigned long crc) {
+	static const vector<unsigned long> table = [] {
+		vector<unsigned long> t(256);
+		for (unsigned long n=0; n<256; n++) {
+			unsigned long c = n;
+			for (int k=0; k<8; k++) c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+		return t;
+	}();
+	const unsigned char *b = (const unsigned char *)data;
+	crc = crc ^ 0xFFFFFFFFUL;
+	for (size_t i=0; i<len; i++) crc = table[(crc ^ b[i]) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFFUL;
+}
+
+/***************
+ * mapped file *
+ ***************/
+
+MappedFile::MappedFile(string path) : addr(NULL), len(0) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return;
+	struct stat st;
+	if (fstat(fd, &st) == 0 and st.st_size > 0) {
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			this->addr = p;
+			this->len = st.st_size;
+		}
+	}
+	close(fd); /* mapping stays valid */
+}
+
+MappedFile::~MappedFile() {
+	if (this->addr) munmap(this->addr, this->len);
+}
+
+
+/*****************
+ * atomic writes *
+ *****************/
+
+bool write_atomic(string path, function<bool(ofstream &)> writer) {
+	size_t slash = path.rfind('/');
+	string tmp = path.substr(0, slash+1)+"."+path.substr(slash+1)+"."+to_string(getpid())+".tmp";
+	ofstream ofile(tmp.c_str(), ios::out | ios::trunc | ios::binary);
+	if (!ofile.is_open()) return false;
+	bool ok = writer(ofile);
+	ofile.close();
+	if (!ok or ofile.fail() or rename(tmp.c_str(), path.c_str())) {
+		remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
 
-/* Finds minimum value in float array
+
+/**************
+ * file watch *
+ **************/
+
+/* interval of polling file size and modification time [s] */
+const double WATCH_POLL_INTERVAL = 5.0;
+
+FileWatch::FileWatch(string path) : path(path), fd(-1), wd(-1), last_size(0), last_mtime(0), is_closed(false) {
+	this->changed();
+	this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (this->fd >= 0) {
+		this->wd = inotify_add_watch(this->fd, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE);
+		if (this->wd < 0) {
+			close(this->fd);
+			this->fd = -1;
+		}
+	}
+	if (this->fd < 0) printf("WARNING: inotify not available for %s, polling every %g s\n", path.c_str(), WATCH_POLL_INTERVAL);
+}
+
+FileWatch::~FileWatch() {
+	if (this->fd >= 0) close(this->fd);
+}
+
+bool FileWatch::changed() {
+	struct stat st;
+	if (stat(this->path.c_str(), &st)) return false;
+	bool changed = st.st_size != this->last_size or st.st_mtime != this->last_mtime;
+	this->last_size = st.st_size;
+	this->last_mtime = st.st_mtime;
+	return changed;
+}
+
+WatchEvent FileWatch::wait(double timeout) {
+	double waited = 0.0;
+	while (waited < timeout) {
+		double step = min(WATCH_POLL_INTERVAL, timeout-waited);
+		if (this->fd >= 0) {
+			struct pollfd pfd = {this->fd, POLLIN, 0};
+			if (poll(&pfd, 1, int(step*1000)) > 0) {
+				/* drain queued events (last one decides) */
+				char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+				ssize_t len;
+				WatchEvent ev = WATCH_TIMEOUT;
+				while ((len = read(this->fd, buf, sizeof(buf))) > 0) {
+					for (char *p = buf; p < buf+len; p += sizeof(struct inotify_event)+((struct inotify_event *)p)->len) {
+						uint32_t mask = ((struct inotify_event *)p)->mask;
+						if (mask & IN_MODIFY) ev = WATCH_MODIFIED;
+						if (mask & IN_CLOSE_WRITE) ev = WATCH_CLOSED;
+					}
+				}
+				this->changed();
+				if (ev != WATCH_TIMEOUT) {
+					this->is_closed = (ev == WATCH_CLOSED);
+					return ev;
+				}
+			}
+		} else {
+			usleep(useconds_t(step*1e6));
+		}
+		waited += step;
+		if (this->changed()) {
+			this->is_closed = false;
+			return WATCH_MODIFIED;
+		}
+	}
+	return WATCH_TIMEOUT;
+}
+
+/*************************
+ * vectorized reductions *
+ *************************/
+
+/* Reduction kernels accumulate into r (sum holds sum of deviations from shift)
+ * and return the number of processed values. The scalar kernel processes all
+ * values and handles the remainder of the SIMD kernels.
+ */
+template <bool SKIPNAN, bool MOMENTS>
+static size_t reduce_scalar(const float *v, size_t n, float shift, VecReduce *r) {
+	for (size_t i=0; i<n; i++) {
+		float x = v[i];
+		if (SKIPNAN and x != x) continue;
+		if (x < r->min) r->min = x;
+		if (x > r->max) r->max = x;
+		if (MOMENTS) {
+			double d = double(x-shift);
+			r->sum += d;
+			r->sumsq += d*d;
+		}
+		r->count++;
+	}
+	return n;
+}
+
+#ifdef SIMD_X86
+template <bool SKIPNAN, bool MOMENTS>
+__attribute__((target("sse2")))
+static size_t reduce_sse2(const float *v, size_t n, float shift, VecReduce *r) {
+	__m128 vmin = _mm_set1_ps(r->min), vmax = _mm_set1_ps(r->max);
+	__m128 vshift = _mm_set1_ps(shift);
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+	size_t count = 0, i = 0;
+	for (; i+4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps(v+i);
+		__m128 d = _mm_sub_ps(x, vshift);
+		if (SKIPNAN) {
+			__m128 ok = _mm_cmpord_ps(x, x);
+			vmin = _mm_min_ps(vmin, _mm_or_ps(_mm_and_ps(ok, x), _mm_andnot_ps(ok, vmin)));
+			vmax = _mm_max_ps(vmax, _mm_or_ps(_mm_and_ps(ok, x), _mm_andnot_ps(ok, vmax)));
+			count += __builtin_popcount(_mm_movemask_ps(ok));
+			d = _mm_and_ps(d, ok);
+		} else {
+			vmin = _mm_min_ps(vmin, x);
+			vmax = _mm_max_ps(vmax, x);
+		}
+		if (MOMENTS) {
+			__m128d d0 = _mm_cvtps_pd(d), d1 = _mm_cvtps_pd(_mm_movehl_ps(d, d));
+			s0 = _mm_add_pd(s0, d0);
+			s1 = _mm_add_pd(s1, d1);
+			q0 = _mm_add_pd(q0, _mm_mul_pd(d0, d0));
+			q1 = _mm_add_pd(q1, _mm_mul_pd(d1, d1));
+		}
+	}
+	float fmin[4], fmax[4];
+	double sum[2], sumsq[2];
+	_mm_storeu_ps(fmin, vmin);
+	_mm_storeu_ps(fmax, vmax);
+	_mm_storeu_pd(sum, _mm_add_pd(s0, s1));
+	_mm_storeu_pd(sumsq, _mm_add_pd(q0, q1));
+	for (int k=0; k<4; k++) {
+		if (fmin[k] < r->min) r->min = fmin[k];
+		if (fmax[k] > r->max) r->max = fmax[k];
+	}
+	r->sum += sum[0]+sum[1];
+	r->sumsq += sumsq[0]+sumsq[1];
+	r->count += SKIPNAN ? count : i;
+	return i;
+}
+
+template <bool SKIPNAN, bool MOMENTS>
+__attribute__((target("avx2,fma")))
+static size_t reduce_avx2(const float *v, size_t n, float shift, VecReduce *r) {
+	__m256 vmin = _mm256_set1_ps(r->min), vmax = _mm256_set1_ps(r->max);
+	__m256 vshift = _mm256_set1_ps(shift);
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+	size_t count = 0, i = 0;
+	for (; i+8 <= n; i += 8) {
+		__m256 x = _mm256_loadu_ps(v+i);
+		__m256 d = _mm256_sub_ps(x, vshift);
+		if (SKIPNAN) {
+			__m256 ok = _mm256_cmp_ps(x, x, _CMP_ORD_Q);
+			vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(vmin, x, ok));
+			vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(vmax, x, ok));
+			count += __builtin_popcount(_mm256_movemask_ps(ok));
+			d = _mm256_and_ps(d, ok);
+		} else {
+			vmin = _mm256_min_ps(vmin, x);
+			vmax = _mm256_max_ps(vmax, x);
+		}
+		if (MOMENTS) {
+			__m256d d0 = _mm256_cvtps_pd(_mm256_castps256_ps128(d)), d1 = _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1));
+			s0 = _mm256_add_pd(s0, d0);
+			s1 = _mm256_add_pd(s1, d1);
+			q0 = _mm256_fmadd_pd(d0, d0, q0);
+			q1 = _mm256_fmadd_pd(d1, d1, q1);
+		}
+	}
+	float fmin[8], fmax[8];
+	double sum[4], sumsq[4];
+	_mm256_storeu_ps(fmin, vmin);
+	_mm256_storeu_ps(fmax, vmax);
+	_mm256_storeu_pd(sum, _mm256_add_pd(s0, s1));
+	_mm256_storeu_pd(sumsq, _mm256_add_pd(q0, q1));
+	for (int k=0; k<8; k++) {
+		if (fmin[k] < r->min) r->min = fmin[k];
+		if (fmax[k] > r->max) r->max = fmax[k];
+	}
+	r->sum += sum[0]+sum[1]+sum[2]+sum[3];
+	r->sumsq += sumsq[0]+sumsq[1]+sumsq[2]+sumsq[3];
+	r->count += SKIPNAN ? count : i;
+	return i;
+}
+#endif
+
+/* selects reduction kernels supported by current CPU (indexed by [skipnan][moments]) */
+typedef size_t (*reduce_fcn)(const float *, size_t, float, VecReduce *);
+
+struct ReduceKernels {
+	reduce_fcn fcn[2][2];
+	ReduceKernels() {
+		fcn[0][0] = reduce_scalar<false,false>; fcn[0][1] = reduce_scalar<false,true>;
+		fcn[1][0] = reduce_scalar<true,false>; fcn[1][1] = reduce_scalar<true,true>;
+#ifdef SIMD_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma")) {
+			fcn[0][0] = reduce_avx2<false,false>; fcn[0][1] = reduce_avx2<false,true>;
+			fcn[1][0] = reduce_avx2<true,false>; fcn[1][1] = reduce_avx2<true,true>;
+		} else if (__builtin_cpu_supports("sse2")) {
+			fcn[0][0] = reduce_sse2<false,false>; fcn[0][1] = reduce_sse2<false,true>;
+			fcn[1][0] = reduce_sse2<true,false>; fcn[1][1] = reduce_sse2<true,true>;
+		}
+#endif
+	}
+};
+
+/* reduces contiguous range (SIMD kernel and scalar remainder) */
+static void reduce_range(const float *v, size_t n, bool skipnan, bool moments, float shift, VecReduce *r) {
+	static ReduceKernels kernels;
+	size_t i = kernels.fcn[skipnan][moments](v, n, shift, r);
+	if (skipnan) {
+		if (moments) reduce_scalar<true,true>(v+i, n-i, shift, r);
+		else reduce_scalar<true,false>(v+i, n-i, shift, r);
+	} else {
+		if (moments) reduce_scalar<false,true>(v+i, n-i, shift, r);
+		else reduce_scalar<false,false>(v+i, n-i, shift, r);
+	}
+}
+
+VecReduce vec_reduce(size_t len, const float *vec, bool skipnan, bool moments, float shift, int nthreads) {
+	if (nthreads <= 0) nthreads = thread::hardware_concurrency();
+	VecReduce init = {HUGE_VALF, -HUGE_VALF, 0, 0, 0};
+	vector<VecReduce> part(max(nthreads, 1), init);
+	parallel_chunks(len, nthreads, size_t(1) << 18, [&](int c, size_t first, size_t last) {
+		reduce_range(&vec[first], last-first, skipnan, moments, shift, &part[c]);
+	});
+	VecReduce r = init;
+	for (size_t c=0; c<part.size(); c++) {
+		if (part[c].min < r.min) r.min = part[c].min;
+		if (part[c].max > r.max) r.max = part[c].max;
+		r.sum += part[c].sum;
+		r.sumsq += part[c].sumsq;
+		r.count += part[c].count;
+	}
+	r.sum += double(shift)*r.count; /* kernels sum deviations from shift */
+	return r;
+}
+
+float vec_min(size_t len, const float *vec, bool skipnan, int nthreads) {
+	return vec_reduce(len, vec, skipnan, false, 0, nthreads).min;
+}
+
+float vec_max(size_t len, const float *vec, bool skipnan, int nthreads) {
+	return vec_reduce(len, vec, skipnan, false, 0, nthreads).max;
+}
+
+void vec_minmax(size_t len, const float *vec, float *minval, float *maxval, bool skipnan, int nthreads) {
+	VecReduce r = vec_reduce(len, vec, skipnan, false, 0, nthreads);
+	*minval = r.min;
+	*maxval = r.max;
+}
+
+double vec_sum(size_t len, const float *vec, bool skipnan, int nthreads) {
+	return vec_reduce(len, vec, skipnan, true, 0, nthreads).sum;
+}
+
+double vec_sumsq(size_t len, const float *vec, float shift, bool skipnan, int nthreads) {
+	return vec_reduce(len, vec, skipnan, true, shift, nthreads).sumsq;
+}
+
+/* returns index of first element equal to val (len if not found) */
+size_t vec_find(size_t len, const float *vec, float val) {
+	size_t i = 0;
+#ifdef SIMD_X86
+	__m128 vval = _mm_set1_ps(val);
+	for (; i+16 <= len; i += 16) {
+		int m = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(vec+i), vval))
+			  | _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(vec+i+4), vval)) << 4
+			  | _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(vec+i+8), vval)) << 8
+			  | _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(vec+i+12), vval)) << 12;
+		if (m) return i+__builtin_ctz(m);
+	}
+#endif
+	for (; i<len; i++) if (vec[i] == val) return i;
+	return len;
+}
+
+/* Finds minimum value in float array (NaN values are ignored)
  * INPUT:
  * 	len	number of array elements
  * 	vec	float array
@@ -254,24 +852,21 @@ string time2str(void* ch, int n) {
  * 	pos	index of minimum value in array
  */
 float min(size_t len, float *vec, size_t *pos) {
-	float val = vec[0];
-	*pos = 0;
-	for (size_t i=1; i<len; i++) {
-		if (vec[i] < val) {
-			val = vec[i];
-			*pos = i;
-		}
+	VecReduce r = vec_reduce(len, vec, true, false);
+	if (r.count == 0) { /* no valid value */
+		*pos = 0;
+		return vec[0];
 	}
-	return val;
+	*pos = vec_find(len, vec, r.min);
+	return r.min;
 }
 
 float min(size_t len, float *vec) {
-	size_t pos;
-	return min(len, vec, &pos);
-
+	VecReduce r = vec_reduce(len, vec, true, false);
+	return (r.count == 0) ? vec[0] : r.min;
 }
 
-/* Finds maximum value in float array
+/* Finds maximum value in float array (NaN values are ignored)
  * INPUT:
  * 	len	number of array elements
  * 	vec	float array
@@ -279,24 +874,21 @@ float min(size_t len, float *vec) {
  * 	pos	index of maximum value in array
  */
 float max(size_t len, float *vec, size_t *pos) {
-	float val = vec[0];
-	*pos = 0;
-	for (size_t i=1; i<len; i++) {
-		if (vec[i] > val) {
-			val = vec[i];
-			*pos = i;
-		}
+	VecReduce r = vec_reduce(len, vec, true, false);
+	if (r.count == 0) { /* no valid value */
+		*pos = 0;
+		return vec[0];
 	}
-	return val;
+	*pos = vec_find(len, vec, r.max);
+	return r.max;
 }
 
 float max(size_t len, float *vec) {
-	size_t pos;
-	return min(len, vec, &pos);
-
+	VecReduce r = vec_reduce(len, vec, true, false);
+	return (r.count == 0) ? vec[0] : r.max;
 }
 
-/* Finds minimum and maximum value in float array
+/* Finds minimum and maximum value in float array (NaN values are ignored)
  * INPUT:
  * 	len	number of array elements
  * 	vec	float array
@@ -306,27 +898,180 @@ float max(size_t len, float *vec) {
  * 	maxpos	index of maximum value in array
  */
 float minmax(size_t len, float *vec, float *maxval, size_t *minpos, size_t *maxpos) {
-	float minval = vec[0];
-	*maxval = vec[0];
-	*minpos = 0;
-	*maxpos = 0;
-	for (size_t i=1; i<len; i++) {
-		if (vec[i] < minval) {
-			minval = vec[i];
-			*minpos = i;
-		}
-		if (vec[i] > *maxval) {
-			*maxval = vec[i];
-			*maxpos = i;
-		}
+	VecReduce r = vec_reduce(len, vec, true, false);
+	if (r.count == 0) { /* no valid value */
+		*minpos = *maxpos = 0;
+		*maxval = vec[0];
+		return vec[0];
 	}
-	return minval;
+	*minpos = vec_find(len, vec, r.min);
+	*maxpos = vec_find(len, vec, r.max);
+	*maxval = r.max;
+	return r.min;
 }
 
 float minmax(size_t len, float *vec, float *maxval) {
-	size_t minpos, maxpos;
-	return minmax(len, vec, maxval, &minpos, &maxpos);
+	VecReduce r = vec_reduce(len, vec, true, false);
+	*maxval = (r.count == 0) ? vec[0] : r.max;
+	return (r.count == 0) ? vec[0] : r.min;
+}
+
+/**************
+ * statistics *
+ **************/
+
+/* merges statistics of another part of the array */
+void FieldStats::merge(const FieldStats &o) {
+	this->nans += o.nans;
+	if (o.count == 0) return;
+	if (this->count == 0) {
+		size_t nans = this->nans;
+		*this = o;
+		this->nans = nans;
+		return;
+	}
+	double n = double(this->count)+double(o.count);
+	double delta = o.mean-this->mean;
+	this->mean += delta*o.count/n;
+	this->m2 += o.m2+delta*delta*(double(this->count)*double(o.count)/n);
+	this->count += o.count;
+	if (o.min < this->min) this->min = o.min;
+	if (o.max > this->max) this->max = o.max;
+}
+
+/* elements reduced per block (block stays in L1 cache for second pass) */
+const size_t STATS_BLOCK = 4096;
+
+/* statistics of one block: first pass min/max/sum, second pass squared deviations */
+template <typename T> static FieldStats block_stats(const T *v, size_t n) {
+	FieldStats st;
+	T lo = v[0], hi = v[0];
+	double sum = 0;
+	size_t cnt = 0;
+	for (size_t i=0; i<n; i++) {
+		T x = v[i];
+		if (x != x) continue; /* NaN */
+		lo = (x < lo or lo != lo) ? x : lo;
+		hi = (x > hi or hi != hi) ? x : hi;
+		sum += x;
+		cnt++;
+	}
+	st.nans = n-cnt;
+	st.count = cnt;
+	if (cnt == 0) return st;
+	st.min = lo;
+	st.max = hi;
+	st.mean = sum/cnt;
+	double m2 = 0;
+	for (size_t i=0; i<n; i++) {
+		double d = double(v[i])-st.mean;
+		if (d == d) m2 += d*d;
+	}
+	st.m2 = m2;
+	return st;
+}
+
+/* float blocks are reduced in one pass by the SIMD kernel (deviations from first value) */
+template <> FieldStats block_stats<float>(const float *v, size_t n) {
+	FieldStats st;
+	float shift = v[0];
+	for (size_t i=1; i<n and shift != shift; i++) shift = v[i];
+	VecReduce r = {HUGE_VALF, -HUGE_VALF, 0, 0, 0};
+	reduce_range(v, n, true, true, (shift == shift) ? shift : 0, &r);
+	st.nans = n-r.count;
+	st.count = r.count;
+	if (r.count == 0) return st;
+	double dmean = r.sum/r.count; /* mean deviation from shift */
+	st.min = r.min;
+	st.max = r.max;
+	st.mean = dmean+((shift == shift) ? shift : 0);
+	st.m2 = max(0.0, r.sumsq-dmean*r.sum);
+	return st;
+}
+
+/* statistics of contiguous range (reduced block by block) */
+template <typename T> static FieldStats range_stats(const T *v, size_t n) {
+	FieldStats st;
+	for (size_t i=0; i<n; i+=STATS_BLOCK) st.merge(block_stats(&v[i], min(STATS_BLOCK, n-i)));
+	return st;
+}
+
+template <typename T> FieldStats field_stats(size_t len, const T *vec, int nthreads) {
+	if (nthreads <= 0) nthreads = thread::hardware_concurrency();
+	vector<FieldStats> part(max(nthreads, 1));
+	parallel_chunks(len, nthreads, 16*STATS_BLOCK, [&](int c, size_t first, size_t last) {
+		part[c] = range_stats(&vec[first], last-first);
+	});
+	FieldStats st;
+	for (size_t c=0; c<part.size(); c++) st.merge(part[c]);
+	return st;
+}
+
+template FieldStats field_stats<short>(size_t, const short *, int);
+template FieldStats field_stats<int>(size_t, const int *, int);
+template FieldStats field_stats<float>(size_t, const float *, int);
+template FieldStats field_stats<double>(size_t, const double *, int);
+
+/* Runs func(chunk, first, last) for contiguous chunks of [0,len) in parallel
+ * (chunk 0 is processed by calling thread) */
+void parallel_chunks(size_t len, int nthreads, size_t minlen, const function<void(int, size_t, size_t)> &func) {
+	if (nthreads <= 0) nthreads = thread::hardware_concurrency();
+	if (minlen < 1) minlen = 1;
+	size_t nmax = (len+minlen-1)/minlen;
+	if (size_t(nthreads) > nmax) nthreads = nmax;
+	if (nthreads <= 1) {
+		if (len > 0) func(0, 0, len);
+		return;
+	}
+	size_t chunk = ((len+nthreads-1)/nthreads+63) & ~size_t(63); /* chunks aligned to cache lines */
+	vector<thread> workers;
+	for (int c=1; c<nthreads; c++) {
+		size_t first = min(len, c*chunk), last = min(len, (c+1)*chunk);
+		if (first < last) workers.push_back(thread(func, c, first, last));
+	}
+	func(0, 0, min(len, chunk));
+	for (size_t i=0; i<workers.size(); i++) workers[i].join();
+}
+
+/* Downsamples 2D float array by block averaging
+ * INPUT:
+ * 	nx, ny	dimensions of input array (x is fastest varying)
+ * 	vec		input array
+ * 	fac		downsampling factor
+ * OUTPUT:
+ * 	out		output array with (nx/fac)*(ny/fac) elements
+ */
+void downsample_mean(size_t nx, size_t ny, float *vec, int fac, float *out) {
+	size_t nxo = nx/fac;
+	size_t nyo = ny/fac;
+	float norm = 1.0/float(fac*fac);
+
+	for (size_t j=0; j<nyo; j++) {
+		float *o = &out[j*nxo];
+		for (size_t i=0; i<nxo; i++) o[i] = 0.0;
 
+		/* accumulate block rows (inner loops run over whole output rows
+		 * so that they can be vectorized by the compiler) */
+		for (int r=0; r<fac; r++) {
+			float *in = &vec[(j*fac+r)*nx];
+			for (int k=0; k<fac; k++) {
+				for (size_t i=0; i<nxo; i++) o[i] += in[i*fac+k];
+			}
+		}
+		for (size_t i=0; i<nxo; i++) o[i] *= norm;
+	}
+}
+
+/* Downsamples 2D float array by picking the centre element of each block */
+void downsample_nearest(size_t nx, size_t ny, float *vec, int fac, float *out) {
+	size_t nxo = nx/fac;
+	size_t nyo = ny/fac;
+
+	for (size_t j=0; j<nyo; j++) {
+		float *in = &vec[(j*fac+fac/2)*nx+fac/2];
+		float *o = &out[j*nxo];
+		for (size_t i=0; i<nxo; i++) o[i] = in[i*fac];
+	}
 }
 
 /* Interpolates between to float values.
@@ -345,6 +1090,59 @@ float interpol(float val1, float val2, float idx1, float idx2, float idx3) {
 	return m*idx3+n;
 }
 
+/*****************************
+ * height above ground level *
+ *****************************/
+
+AGLProfile::AGLProfile(size_t nx, size_t ny, size_t nz, const float *ght, const float *hgt, const vector<float> &targets)
+		: n_x(nx), n_y(ny), n_z(nz), agl(targets) {
+	size_t n = nx*ny, nt = targets.size();
+	if (nz < 2) {
+		printf("ABORT: Height above ground interpolation requires at least 2 levels!\n");
+		exit(EXIT_FAILURE);
+	}
+	this->lo.resize(nt*n);
+	this->h_lo.resize(nt*n);
+	this->h_up.resize(nt*n);
+
+	/* targets in ascending order */
+	vector<size_t> ord(nt);
+	for (size_t t=0; t<nt; t++) ord[t] = t;
+	sort(ord.begin(), ord.end(), [&](size_t a, size_t b) { return targets[a] < targets[b]; });
+
+	for (size_t p=0; p<n; p++) {
+		size_t k = 0;
+		float a_lo = ght[p]-hgt[p];
+		for (size_t l=1; l<nz and k<nt; l++) {
+			float a_up = ght[l*n+p]-hgt[p]; // height above ground of level l
+			while (k < nt and (a_up - targets[ord[k]]) > 0) {
+				size_t idx = ord[k]*n+p;
+				this->lo[idx] = l-1;
+				this->h_lo[idx] = a_lo;
+				this->h_up[idx] = a_up;
+				k++;
+			}
+			a_lo = a_up;
+		}
+		/* targets above column */
+		for (; k<nt; k++) {
+			size_t idx = ord[k]*n+p;
+			this->lo[idx] = nz-2;
+			this->h_lo[idx] = ght[(nz-2)*n+p]-hgt[p];
+			this->h_up[idx] = ght[(nz-1)*n+p]-hgt[p];
+		}
+	}
+}
+
+void AGLProfile::interpolate(const float *field, size_t t, float *out) const {
+	size_t n = this->n_x*this->n_y;
+	const unsigned *lo = &this->lo[t*n];
+	const float *h_lo = &this->h_lo[t*n], *h_up = &this->h_up[t*n];
+	for (size_t p=0; p<n; p++) {
+		out[p] = interpol(field[lo[p]*n+p], field[(lo[p]+1)*n+p], h_lo[p], h_up[p], this->agl[t]);
+	}
+}
+
 /* Calculates relative humidity from WRF output.
  * INPUT:
  * 	qv	Water vapor mixing ratio [kg/kg]
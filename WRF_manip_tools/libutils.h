@@ -11,10 +11,33 @@
 #define LIBUTILS_H_
 
 #include <string>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <charconv>
+#include <functional>
+#include <math.h>
+#include <sys/types.h>
 
 using namespace std;
 
-typedef char byte;
+typedef char byte; /* use as ::byte (std::byte exists since C++17) */
+
+/* byte order of encoded data */
+enum Endian { ENDIAN_LITTLE, ENDIAN_BIG };
+
+/* byte order of host (detected at compile time) */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+const Endian ENDIAN_HOST = ENDIAN_BIG;
+#else
+const Endian ENDIAN_HOST = ENDIAN_LITTLE;
+#endif
+
+/* byte order of IFF and geogrid binary files (big endian as written by WPS) */
+const Endian ENDIAN_IFF = ENDIAN_BIG;
+const Endian ENDIAN_GEO = ENDIAN_BIG;
 
 /* union for data type conversion */
 union buf{
@@ -27,31 +50,282 @@ union buf{
 };
 
 /* converts 2 Byte array into short integer */
-short b2s(byte b[2], bool endian);
+short b2s(::byte b[2], bool endian);
 
 /* converts short integer into 2 Byte array */
-void s2b(short i, byte b[2], bool endian);
+void s2b(short i, ::byte b[2], bool endian);
 
 /* converts 4 Byte array into integer */
-int b2i(byte b[4], bool endian);
+int b2i(::byte b[4], bool endian);
 
 /* converts integer into 4 Byte array */
-void i2b(int i, byte b[4], bool endian);
+void i2b(int i, ::byte b[4], bool endian);
 
 /* converts Byte array into float */
-float b2f(byte *b, bool endian, int n);
+float b2f(::byte *b, bool endian, int n);
 
 /* converts 4 Byte array into float */
-float b2f(byte b[4], bool endian);
+float b2f(::byte b[4], bool endian);
 
 /* converts float into Byte array */
-void f2b(float f, byte *b, bool endian, int n);
+void f2b(float f, ::byte *b, bool endian, int n);
 
 /* converts float into 4 Byte array */
-void f2b(float f, byte b[4], bool endian);
+void f2b(float f, ::byte b[4], bool endian);
+
+/* Byte-swaps arrays of n 2, 4 or 8 Byte values from src into dst.
+ * SSSE3/AVX2 shuffle kernels are selected at runtime if the CPU supports them.
+ * INPUT:
+ * 	src		source array
+ * 	n		number of values
+ * OUTPUT:
+ * 	dst		destination array (may be identical to src)
+ */
+void bswap16_n(const void *src, void *dst, size_t n);
+void bswap32_n(const void *src, void *dst, size_t n);
+void bswap64_n(const void *src, void *dst, size_t n);
+
+/* in-place variants */
+void bswap16_n(void *buf, size_t n);
+void bswap32_n(void *buf, size_t n);
+void bswap64_n(void *buf, size_t n);
+
+/* byte swap of single values and arrays (selected by value size) */
+template <size_t N> struct bswap_value;
+
+template <> struct bswap_value<1> {
+	template <typename T> static T swap(T v) { return v; }
+	static void swap_n(const void *src, void *dst, size_t n) { if (src != dst) memcpy(dst, src, n); }
+};
+
+template <> struct bswap_value<2> {
+	template <typename T> static T swap(T v) {
+		unsigned short u; memcpy(&u, &v, 2); u = __builtin_bswap16(u); memcpy(&v, &u, 2); return v;
+	}
+	static void swap_n(const void *src, void *dst, size_t n) { bswap16_n(src, dst, n); }
+};
+
+template <> struct bswap_value<4> {
+	template <typename T> static T swap(T v) {
+		unsigned int u; memcpy(&u, &v, 4); u = __builtin_bswap32(u); memcpy(&v, &u, 4); return v;
+	}
+	static void swap_n(const void *src, void *dst, size_t n) { bswap32_n(src, dst, n); }
+};
+
+template <> struct bswap_value<8> {
+	template <typename T> static T swap(T v) {
+		unsigned long long u; memcpy(&u, &v, 8); u = __builtin_bswap64(u); memcpy(&v, &u, 8); return v;
+	}
+	static void swap_n(const void *src, void *dst, size_t n) { bswap64_n(src, dst, n); }
+};
+
+/* Decodes value of type T from Byte array stored in byte order E.
+ * The byte order is resolved at compile time, i.e. decoding is a plain copy
+ * for host byte order and a single byte swap otherwise.
+ */
+template <Endian E, typename T> inline T decode(const ::byte *b) {
+	T v;
+	memcpy(&v, b, sizeof(T));
+	if (E != ENDIAN_HOST) v = bswap_value<sizeof(T)>::swap(v);
+	return v;
+}
+
+/* Encodes value of type T into Byte array using byte order E. */
+template <Endian E, typename T> inline void encode(T v, ::byte *b) {
+	if (E != ENDIAN_HOST) v = bswap_value<sizeof(T)>::swap(v);
+	memcpy(b, &v, sizeof(T));
+}
+
+/* Decodes array of n values of type T stored in byte order E (b may be identical to v). */
+template <Endian E, typename T> inline void decode_n(const void *b, T *v, size_t n) {
+	if (E != ENDIAN_HOST) bswap_value<sizeof(T)>::swap_n(b, v, n);
+	else if (b != (const void *)v) memcpy(v, b, n*sizeof(T));
+}
+
+/* Encodes array of n values of type T into byte order E (b may be identical to v). */
+template <Endian E, typename T> inline void encode_n(const T *v, void *b, size_t n) {
+	if (E != ENDIAN_HOST) bswap_value<sizeof(T)>::swap_n(v, b, n);
+	else if (b != (const void *)v) memcpy(b, v, n*sizeof(T));
+}
+
+/* Size-classed buffer pool for per-record and per-time-step buffers.
+ * Buffers are 64 Byte aligned and rounded up to size classes with four classes
+ * per power of two (at most 25% slack). Released buffers are kept on a free
+ * list of their class and handed out again, so repeated steps with identical
+ * buffer sizes reach a steady state without any system allocation.
+ * Acquire/release are thread-safe.
+ */
+class BufferPool {
+public:
+	BufferPool();
+	~BufferPool(); // frees all memory (also buffers still in use)
+
+	void *acquire(size_t bytes); // returns buffer of at least bytes Bytes
+	void release(void *ptr); // returns buffer to pool (NULL and buffers already returned by reset() are ignored)
+	void reset(void); // returns all buffers in use to pool (e.g. at end of time step)
+	void purge(void); // frees all cached (unused) buffers
+
+	/* counters */
+	size_t allocations(void) const { return n_alloc; } // number of system allocations
+	size_t acquisitions(void) const { return n_acquire; } // number of acquired buffers
+	size_t reuses(void) const { return n_acquire-n_alloc; } // number of buffers served from cache
+	size_t in_use(void) const { return n_used; } // number of buffers currently in use
+	size_t reserved(void) const { return n_reserved; } // Bytes currently allocated from system
+	void print_stats(string name); // prints counters
+
+private:
+	struct Block; // header in front of each buffer
+	static const int NCLASS = 4*58+1; // classes from 64 Bytes up to 2^63 Bytes
+	Block *free_list[NCLASS];
+	Block *used_list;
+	size_t n_alloc, n_acquire, n_used, n_reserved;
+	mutex lock;
+
+	BufferPool(const BufferPool &) = delete;
+	BufferPool &operator=(const BufferPool &) = delete;
+};
+
+/* process wide buffer pool */
+BufferPool &buffer_pool(void);
+
+/* Buffered writer collecting formatted output in one large block which is
+ * written to the output stream when full (or on flush/destruction).
+ * Numbers are formatted with std::to_chars (shortest round-trip representation).
+ */
+class BlockWriter {
+public:
+	BlockWriter(FILE *out = stdout, size_t size = 1<<20);
+	~BlockWriter(); // flushes remaining output
+
+	void put(char c) {
+		if (this->pos == this->end) this->flush();
+		*this->pos++ = c;
+	}
+	void put(const char *s, size_t n);
+	void put(const string &s) { this->put(s.data(), s.size()); }
+
+	/* formats number (characters are written as they are) */
+	template <typename T> void number(T v) {
+		if (this->end-this->pos < 32) this->flush();
+		this->pos = to_chars(this->pos, this->end, v).ptr;
+	}
+	void number(char c) { this->put(c); }
+
+	void flush(void);
+
+private:
+	FILE *out;
+	char *block, *pos, *end;
+
+	BlockWriter(const BlockWriter &) = delete;
+	BlockWriter &operator=(const BlockWriter &) = delete;
+};
+
+/* output layouts of print_values */
+enum PrintLayout {
+	PRINT_NESTED,	/* nested brackets, e.g. [[1, 2], [3, 4]] (one line per innermost row) */
+	PRINT_NCDUMP,	/* ncdump data section, e.g. " VAR =\n  1, 2,\n  3, 4 ;" */
+	PRINT_CSV		/* one line per value: indices of all dimensions and value */
+};
+
+/* Prints n-dimensional array in given layout. The type is resolved once per call,
+ * rows of the innermost dimension are printed in a tight loop.
+ * INPUT:
+ * 	out			writer used for output
+ * 	data		array values (last dimension fastest varying)
+ * 	ndims		number of dimensions
+ * 	start		start index of each dimension (used for CSV indices)
+ * 	count		length of each dimension
+ * 	name		variable name (used for NCDUMP and CSV headers)
+ * 	dimnames	dimension names (used for CSV header)
+ * 	stride		index stride of each dimension (used for CSV indices, NULL: 1)
+ * Character arrays are printed as strings (one per row) for NCDUMP and CSV layouts.
+ */
+template <typename T>
+void print_values(BlockWriter *out, const T *data, int ndims, const size_t *start, const size_t *count,
+		PrintLayout layout, string name, const vector<string> &dimnames, const ptrdiff_t *stride = NULL) {
+	const bool is_text = (sizeof(T) == 1 && layout != PRINT_NESTED);
+	/* absolute index of element i in dimension d */
+	auto index = [&](int d, size_t i) { return start[d] + i*(stride ? stride[d] : 1); };
+	size_t rowlen = ndims ? count[ndims-1] : 1;
+	size_t nrows = 1;
+	for (int d=0; d<ndims-1; d++) nrows *= count[d];
+	vector<size_t> idx(ndims > 1 ? ndims-1 : 1, 0); /* index of current row */
+
+	/* headers */
+	if (layout == PRINT_NCDUMP) {
+		out->put(" "); out->put(name); out->put(" =\n");
+	} else if (layout == PRINT_CSV) {
+		int nidx = is_text ? ndims-1 : ndims;
+		for (int d=0; d<nidx; d++) { out->put(dimnames[d]); out->put(','); }
+		out->put(name); out->put('\n');
+	}
+	if (rowlen == 0) nrows = 0;
+
+	for (size_t r=0; r<nrows; r++) {
+		const T *row = &data[r*rowlen];
+
+		/* opening of row */
+		if (layout == PRINT_NESTED) {
+			int o = ndims-1; /* outermost dimension opened with this row */
+			while (o > 0 && idx[o-1] == 0) o--;
+			for (int d=o; d<ndims; d++) {
+				if (d > 0) out->put('\n');
+				for (int k=0; k<d; k++) out->put(' ');
+				out->put('[');
+			}
+		} else if (layout == PRINT_NCDUMP) {
+			out->put("  ");
+		}
 
-/* allocates a 2D float array */
-float** allocate2D(int ncols, int nrows);
+		/* values of row */
+		if (layout == PRINT_CSV) {
+			if (is_text) {
+				for (int d=0; d<ndims-1; d++) { out->number(index(d, idx[d])); out->put(','); }
+				size_t n = rowlen;
+				while (n > 0 && row[n-1] == 0) n--;
+				out->put('"'); out->put((const char *)row, n); out->put("\"\n");
+			} else {
+				for (size_t i=0; i<rowlen; i++) {
+					for (int d=0; d<ndims-1; d++) { out->number(index(d, idx[d])); out->put(','); }
+					if (ndims > 0) { out->number(index(ndims-1, i)); out->put(','); }
+					out->number(row[i]);
+					out->put('\n');
+				}
+			}
+		} else if (is_text) {
+			size_t n = rowlen;
+			while (n > 0 && row[n-1] == 0) n--;
+			out->put('"'); out->put((const char *)row, n); out->put('"');
+		} else {
+			for (size_t i=0; i<rowlen; i++) {
+				if (i > 0) out->put(", ", 2);
+				out->number(row[i]);
+			}
+		}
+
+		/* closing of row */
+		if (layout == PRINT_NESTED) {
+			int c = ndims-1; /* outermost dimension closed with this row */
+			while (c > 0 && idx[c-1] == count[c-1]-1) c--;
+			for (int d=c; d<ndims; d++) out->put(']');
+		} else if (layout == PRINT_NCDUMP) {
+			if (r == nrows-1) {
+				out->put(" ;\n");
+			} else {
+				out->put(",\n");
+				if (ndims > 2 && idx[ndims-2] == count[ndims-2]-1) out->put('\n'); /* blank line between 2D slabs */
+			}
+		}
+
+		/* next row index */
+		for (int d=ndims-2; d>=0; d--) {
+			if (++idx[d] < count[d]) break;
+			idx[d] = 0;
+		}
+	}
+	if (layout == PRINT_NESTED) out->put('\n');
+}
 
 /* formated print of data in union buf */
 void printvardata(union buf*, size_t*, int, int, long, int);
@@ -69,8 +343,95 @@ string edge_crop(string, char); // removes given character at begin and end of s
  */
 string time2str(void* ch, int n);
 
+/* FNV-1a hash of len Bytes at data (h: hash of preceding data to chain calls) */
+unsigned long long hash_bytes(const void *data, size_t len, unsigned long long h = 14695981039346656037ULL);
+
+/* CRC-32 (IEEE 802.3, same as zlib crc32()) of len Bytes at data (crc: checksum of preceding data to chain calls) */
+unsigned long calc_crc32(const void *data, size_t len, unsigned long crc = 0);
+
+/* Read-only memory mapping of a whole file (pages are loaded on first access) */
+class MappedFile {
+public:
+	MappedFile(string path); // maps file (is_open() is false if file cannot be mapped)
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool is_open() const { return addr != NULL; }
+	const void *data() const { return addr; }
+	size_t size() const { return len; }
+
+private:
+	void *addr;
+	size_t len;
+};
+
+/* Writes file path by writer into a hidden temporary file of the same directory that is renamed to path
+ * when complete, so concurrent readers never see partial files (false: file not written, writer failed) */
+bool write_atomic(string path, function<bool(ofstream &)> writer);
+
 
-/* Finds minimum value in float array
+/* result of FileWatch::wait() */
+enum WatchEvent {
+	WATCH_TIMEOUT,	// file not modified within timeout
+	WATCH_MODIFIED,	// file was modified
+	WATCH_CLOSED	// writer closed file after modifying it
+};
+
+/* Waits for modifications of a file. Events are taken from inotify, size and modification
+ * time are polled in addition (network file systems do not report remote writes to inotify).
+ */
+class FileWatch {
+public:
+	FileWatch(string path);
+	~FileWatch();
+	FileWatch(const FileWatch &) = delete;
+	FileWatch &operator=(const FileWatch &) = delete;
+
+	WatchEvent wait(double timeout); // waits up to timeout seconds for next event
+	time_t mtime() const { return last_mtime; } // modification time of file when last checked
+	bool closed() const { return is_closed; } // writer closed file and did not modify it since
+
+private:
+	string path;
+	int fd, wd;			/* inotify instance and watch (-1: polling only) */
+	off_t last_size;
+	time_t last_mtime;
+	bool is_closed;
+
+	bool changed(); // polls size and modification time
+};
+
+/* Result of vectorized reduction of float array */
+struct VecReduce {
+	float min, max;	/* extrema of valid values (+/-HUGE_VALF if there are none) */
+	double sum;		/* sum of valid values */
+	double sumsq;	/* sum of squared deviations of valid values from shift */
+	size_t count;	/* number of valid values */
+};
+
+/* Reduces float array with SIMD kernels (AVX2 or SSE2, selected at run time).
+ * INPUT:
+ * 	len			number of array elements
+ * 	vec			float array
+ * 	skipnan		exclude NaN values (otherwise the array has to be NaN free)
+ * 	moments		compute sum and sumsq (otherwise only min, max and count)
+ * 	shift		value subtracted before squaring (a typical value avoids cancellation)
+ * 	nthreads	split large arrays over threads (<= 0: all cores)
+ */
+VecReduce vec_reduce(size_t len, const float *vec, bool skipnan = false, bool moments = true, float shift = 0, int nthreads = 1);
+
+/* single reductions based on vec_reduce */
+float vec_min(size_t len, const float *vec, bool skipnan = false, int nthreads = 1);
+float vec_max(size_t len, const float *vec, bool skipnan = false, int nthreads = 1);
+void vec_minmax(size_t len, const float *vec, float *minval, float *maxval, bool skipnan = false, int nthreads = 1);
+double vec_sum(size_t len, const float *vec, bool skipnan = false, int nthreads = 1);
+double vec_sumsq(size_t len, const float *vec, float shift = 0, bool skipnan = false, int nthreads = 1);
+
+/* returns index of first element equal to val (len if not found) */
+size_t vec_find(size_t len, const float *vec, float val);
+
+/* Finds minimum value in float array (NaN values are ignored)
  * INPUT:
  * 	len	number of array elements
  * 	vec	float array
@@ -80,7 +441,7 @@ string time2str(void* ch, int n);
 float min(size_t len, float *vec, size_t *pos);
 float min(size_t len, float *vec);
 
-/* Finds maximum value in float array
+/* Finds maximum value in float array (NaN values are ignored)
  * INPUT:
  * 	len	number of array elements
  * 	vec	float array
@@ -90,7 +451,7 @@ float min(size_t len, float *vec);
 float max(size_t len, float *vec, size_t *pos);
 float max(size_t len, float *vec);
 
-/* Finds minimum and maximum value in float array
+/* Finds minimum and maximum value in float array (NaN values are ignored)
  * INPUT:
  * 	len	number of array elements
  * 	vec	float array
@@ -102,6 +463,48 @@ float max(size_t len, float *vec);
 float minmax(size_t len, float *vec, float *maxval, size_t *minpos, size_t *maxpos);
 float minmax(size_t len, float *vec, float *maxval);
 
+/* Summary statistics of an array (NaN values are counted but not included).
+ * Statistics of parts are combined with merge() (pairwise update of mean and
+ * squared deviations), so chunks can be reduced independently and in any order.
+ */
+struct FieldStats {
+	size_t count;	/* number of valid (non-NaN) values */
+	size_t nans;	/* number of NaN values */
+	double min, max;
+	double mean;	/* mean of valid values */
+	double m2;		/* sum of squared deviations from mean */
+
+	FieldStats() : count(0), nans(0), min(HUGE_VAL), max(-HUGE_VAL), mean(0), m2(0) {}
+	void merge(const FieldStats &o);
+	double var() const { return (this->count > 0) ? this->m2/this->count : 0; } /* population variance */
+	double std() const { return sqrt(this->var()); }
+};
+
+/* Computes statistics of len values of vec (defined for short, int, float and double).
+ * Large arrays are split into nthreads chunks reduced in parallel (nthreads <= 0: all cores).
+ */
+template <typename T> FieldStats field_stats(size_t len, const T *vec, int nthreads = 1);
+
+/* Runs func(chunk, first, last) for nthreads contiguous chunks [first,last) of [0,len) in parallel.
+ * nthreads <= 0 uses all hardware threads, ranges shorter than minlen per thread use fewer threads.
+ */
+void parallel_chunks(size_t len, int nthreads, size_t minlen, const function<void(int, size_t, size_t)> &func);
+
+/* Downsamples 2D float array by block averaging (fac x fac blocks)
+ * INPUT:
+ * 	nx, ny	dimensions of input array (x is fastest varying)
+ * 	vec		input array
+ * 	fac		downsampling factor
+ * OUTPUT:
+ * 	out		output array with (nx/fac)*(ny/fac) elements
+ */
+void downsample_mean(size_t nx, size_t ny, float *vec, int fac, float *out);
+
+/* Downsamples 2D float array by picking the centre element of each block
+ * (same arguments as downsample_mean)
+ */
+void downsample_nearest(size_t nx, size_t ny, float *vec, int fac, float *out);
+
 /* Interpolates between to float values.
  * val1		float value at index 1 (idx1)
  * val2 	float value at index 2 (idx2)
@@ -109,6 +512,34 @@ float minmax(size_t len, float *vec, float *maxval);
  */
 float interpol(float val1, float val2, float idx1, float idx2, float idx_res);
 
+/* Brackets of target heights above ground level (AGL) in the columns of a height field.
+ * Heights above ground are computed once per column and all targets are bracketed in one
+ * upward pass: the upper bracket level is the first level (from level 1) above the target,
+ * targets above the column are extrapolated from the two top levels.
+ * INPUT:
+ *  nx, ny, nz	dimensions of height field (x fastest varying, nz >= 2)
+ *  ght			heights of levels [m]
+ *  hgt			terrain height [m] (nx*ny values)
+ *  targets		target heights above ground [m] (any order)
+ */
+class AGLProfile {
+public:
+	AGLProfile(size_t nx, size_t ny, size_t nz, const float *ght, const float *hgt, const vector<float> &targets);
+
+	size_t ntargets() const { return agl.size(); }
+	float target(size_t t) const { return agl[t]; }
+
+	/* interpolates field given on the nz levels of ght to target t (nx*ny values written to out) */
+	void interpolate(const float *field, size_t t, float *out) const;
+
+private:
+	size_t n_x, n_y, n_z;
+	vector<float> agl;		/* target heights */
+	vector<unsigned> lo;	/* lower bracket level of each target and point (target slowest varying) */
+	vector<float> h_lo;		/* height above ground of lower bracket level */
+	vector<float> h_up;		/* height above ground of upper bracket level */
+};
+
 /*
  * Calculates relative humidity from WRF output.
  * INPUT:
@@ -38,6 +38,7 @@ void WRFcheck(int err, const char* fcn, const char* file, const int line) {
 
 /* constructor of WRFncdf class */
 void WRFncdf::Init(string f, int rw_flag) {
+	this->pool = NULL;
 	size_t len;
 	char dname[NC_MAX_NAME];
 	this->filename = f;
@@ -124,6 +125,8 @@ void WRFncdf::Init(string f, int rw_flag) {
 		this->gatttypes[gattid] = this->gatttype(gattid);
 		this->gattnames.push_back(this->gattname(gattid));
 	}
+	this->gattvals.resize(this->gattnames.size());
+	this->gattread.assign(this->gattnames.size(), false);
 }
 
 /*
@@ -350,7 +353,13 @@ size_t WRFncdf::gattlen(int attid) {
 
 /* returns gloabal att value as union */
 WRFattval WRFncdf::gattval(int attid) {
-	return this->attval(NC_GLOBAL,attid);
+	if (attid < 0 or attid >= int(this->gattread.size())) return this->attval(NC_GLOBAL,attid);
+	/* values are cached, since every read costs several nc_inq_* calls */
+	if (!this->gattread[attid]) {
+		this->gattvals[attid] = this->attval(NC_GLOBAL,attid);
+		this->gattread[attid] = true;
+	}
+	return this->gattvals[attid];
 }
 
 /* returns value of a variable attribute as string
@@ -477,15 +486,19 @@ int WRFncdf::varndims(string vname) {
  * INPUT:	varid	variable id
  */
 size_t *WRFncdf::vardims(int varid) {
-	size_t *dims = (size_t *)malloc(this->varndims(varid)*sizeof(size_t));
-	int vdims[this->varndims(varid)];
-
-	this->stat = nc_inq_var(this->igrp, varid, NULL, NULL, NULL, vdims, NULL);
-   	WRFCHECK(this->stat, nc_inq_var);
-
-	for (int i=0; i<this->varndims(varid); i++) dims[i] = vdims[i];
+	int ndims = this->varndims(varid);
+
+	/* dimension ids are inquired once per variable and cached */
+	if (size_t(varid) >= this->vardimids.size()) this->vardimids.resize(varid+1);
+	vector<size_t> &dims = this->vardimids[varid];
+	if (dims.size() != size_t(ndims)) {
+		int vdims[ndims];
+		this->stat = nc_inq_var(this->igrp, varid, NULL, NULL, NULL, vdims, NULL);
+		WRFCHECK(this->stat, nc_inq_var);
+		dims.assign(vdims, vdims+ndims);
+	}
 
-	return dims;
+	return ndims ? &dims[0] : NULL;
 }
 
 size_t *WRFncdf::vardims(string vname) {
@@ -544,56 +557,112 @@ void* WRFncdf::vardata(string vname, int *type, int *ndims, size_t *start, size_
 
 	*type = this->vartype(vname);
 	*ndims = this->varndims(vname);
-	size_t *dims = this->vardims(vname);
 
 	size_t count = 1;
 	for (int i = 0; i < *ndims; i++) {
 		count *= stop[i];
 	}
 
-	data = (void*) malloc(this->vartypesize(vname) * count);
+	data = this->allocdata(this->vartypesize(vname) * count);
+	this->readslab(this->varid(vname), *type, start, stop, NULL, data);
+
+	return data;
+}
+
+/*
+ * returns strided slab of variable data
+ * INPUT:	vname	variable name
+ *			start[] start index array for slicing
+ *			count[] count array for slicing
+ *			stride[] index stride array for slicing (NULL: contiguous slab)
+ * OUTPUT:	type	variable type identifier
+ * 			ndims	number of dimensions
+ */
+void* WRFncdf::vardata(string vname, int *type, int *ndims, size_t *start, size_t *count, ptrdiff_t *stride) {
+	void *data;
+
+	*type = this->vartype(vname);
+	*ndims = this->varndims(vname);
+
+	size_t n = 1;
+	for (int i = 0; i < *ndims; i++) {
+		n *= count[i];
+	}
 
-	/* read data of selected variable */
+	data = this->allocdata(this->vartypesize(vname) * n);
+	this->readslab(this->varid(vname), *type, start, count, stride, data);
+
+	return data;
+}
+
+/*
+ * reads variable slab into given buffer
+ * INPUT:	vname	variable name
+ *			start[] start index array for slicing
+ *			count[] count array for slicing
+ * OUTPUT:	data	buffer with space for product of count[] values
+ */
+void WRFncdf::vardata(string vname, size_t *start, size_t *count, void *data) {
+	this->readslab(this->varid(vname), this->vartype(vname), start, count, NULL, data);
+}
+
+void WRFncdf::vardata(string vname, size_t *start, size_t *count, ptrdiff_t *stride, void *data) {
+	this->readslab(this->varid(vname), this->vartype(vname), start, count, stride, data);
+}
+
+/* reads slab of variable varid with type into data
+ * (stride NULL reads contiguous slab, otherwise only every stride[i]-th index is read) */
+void WRFncdf::readslab(int varid, int type, size_t *start, size_t *count, ptrdiff_t *stride, void *data) {
 	if (this->inkind == NC_FORMAT_NETCDF4) {
-		this->stat = nc_get_vara(this->igrp, this->varid(vname), start, dims, data);
-		WRFCHECK(this->stat, nc_get_vara);
+		this->stat = nc_get_vars(this->igrp, varid, start, count, stride, data);
+		WRFCHECK(this->stat, nc_get_vars);
 	} else {
 		/* Unfortunately, above typeless copy not allowed for
 		 * classic model
 		 */
-		switch (*type) {
+		switch (type) {
 		case NC_CHAR:
-			this->stat = nc_get_vara_text(this->igrp, this->varid(vname),
-					start, stop, (char *) data);
-			WRFCHECK(this->stat, nc_get_vara_text);
+			this->stat = nc_get_vars_text(this->igrp, varid,
+					start, count, stride, (char *) data);
+			WRFCHECK(this->stat, nc_get_vars_text);
 			break;
 		case NC_SHORT:
-			this->stat = nc_get_vara_short(this->igrp, this->varid(vname),
-					start, stop, (short int *) data);
-			WRFCHECK(this->stat, nc_get_vara_short);
+			this->stat = nc_get_vars_short(this->igrp, varid,
+					start, count, stride, (short int *) data);
+			WRFCHECK(this->stat, nc_get_vars_short);
 			break;
 		case NC_INT:
-			this->stat = nc_get_vara_int(this->igrp, this->varid(vname),
-					start, stop, (int *) data);
-			WRFCHECK(this->stat, nc_get_vara_int);
+			this->stat = nc_get_vars_int(this->igrp, varid,
+					start, count, stride, (int *) data);
+			WRFCHECK(this->stat, nc_get_vars_int);
 			break;
 		case NC_FLOAT:
-			this->stat = nc_get_vara_float(this->igrp, this->varid(vname),
-					start, stop, (float *) data);
-			WRFCHECK(this->stat, nc_get_vara_float);
+			this->stat = nc_get_vars_float(this->igrp, varid,
+					start, count, stride, (float *) data);
+			WRFCHECK(this->stat, nc_get_vars_float);
 			break;
 		case NC_DOUBLE:
-			this->stat = nc_get_vara_double(this->igrp, this->varid(vname),
-					start, stop, (double *) data);
-			WRFCHECK(this->stat, nc_get_vara_double);
+			this->stat = nc_get_vars_double(this->igrp, varid,
+					start, count, stride, (double *) data);
+			WRFCHECK(this->stat, nc_get_vars_double);
 			break;
 		default:
 			printf("ABORT: variable type not implemented!\n");
 			exit(EXIT_FAILURE);
 		}
 	}
+}
 
-	return data;
+/* allocates data buffer (taken from pool if set) */
+void *WRFncdf::allocdata(size_t bytes) {
+	if (this->pool) return this->pool->acquire(bytes);
+	return malloc(bytes);
+}
+
+/* takes data buffers returned by vardata methods from pool
+ * (buffers have to be returned by pool->release() instead of free()) */
+void WRFncdf::setpool(BufferPool *pool) {
+	this->pool = pool;
 }
 
 void* WRFncdf::vardata(string vname, int *type, int *ndims, size_t *stop) {
@@ -633,10 +702,10 @@ void* WRFncdf::vardata(string vname) {
 
 	size_t count = 1;
 	for (int i = 0; i < ndims; i++) {
-		count *= dims[i];
+		count *= this->dimlen(dims[i]);
 	}
 
-	data = (void*) malloc(this->vartypesize(vname) * count);
+	data = this->allocdata(this->vartypesize(vname) * count);
 
 	this->stat = nc_get_var(this->igrp, this->varid(vname),  data);
 	WRFCHECK(this->stat, nc_get_var);
@@ -651,6 +720,18 @@ size_t WRFncdf::dimlen(int dimid) {
 	return this->dimlength[dimid];
 }
 
+/* re-reads length of dimension from file (data appended by other processes
+ * since opening, e.g. time steps of a running WRF simulation, become readable)
+ * INPUT:	dimid	dimension id
+ */
+size_t WRFncdf::syncdimlen(int dimid) {
+	this->stat = nc_sync(this->igrp);
+	WRFCHECK(this->stat, nc_sync);
+	this->stat = nc_inq_dimlen(this->igrp, this->dimids[dimid], &this->dimlength[dimid]);
+	WRFCHECK(this->stat, nc_inq_dimlen);
+	return this->dimlength[dimid];
+}
+
 /* checks if dimension is unlimited
  * INPUT:	dimid	dimension id
  */
@@ -663,61 +744,67 @@ bool WRFncdf::is_unlim(int dimid) {
  * Plotting and printing *
  *************************/
 
-/* formated print of data in union buf */
-void print_data(union buf* buf, size_t count[], int dim, int ndims, long offset, int vtype) {
-	for (int j=0; j<dim-1; j++) {printf(" ");}
-	printf("[");
-	for (long i=0; i<count[dim-1]; i++) {
-		if (dim < ndims) {
-			printf("\n");
-			long offsetcur = count[dim];
-			print_data(buf, count, dim+1, ndims, offset+offsetcur*i, vtype);
-		} else {
-				switch (vtype) {
-				case NC_CHAR:
-					printf("%c", buf->c[i+offset]);
-					break;
-				case NC_SHORT:
-					printf("%i", buf->s[i+offset]);
-					break;
-				case NC_INT:
-					printf("%i", buf->i[i+offset]);
-					break;
-				case NC_FLOAT:
-					printf("%f", buf->f[i+offset]);
-					break;
-				case NC_DOUBLE:
-					printf("%f", buf->d[i+offset]);
-					break;
-				default:
-					printf("ABORT: variable type not implemented!\n");
-					exit(EXIT_FAILURE);
-				}
-				if (i<count[dim-1]-1) printf(", ", dim);
-		}
+/* prints (strided) slab of variable (read in one piece and printed through a block writer) */
+void WRFncdf::printslab(string vname, size_t *start, size_t *count, ptrdiff_t *stride, PrintLayout layout) {
+	int ndims = this->varndims(vname);
+	int vtype;
+	vector<string> dimnames;
+	for (int i = 0; i < ndims; i++) dimnames.push_back(this->vardimname(vname, i));
+
+	// read data
+	union buf buf;
+	buf.v = this->vardata(vname, &vtype, &ndims, start, count, stride);
+
+	// print data (type is dispatched once for the whole slab)
+	BlockWriter out;
+	if (layout == PRINT_NCDUMP) out.put("data:\n\n");
+	switch (vtype) {
+	case NC_CHAR:
+		print_values(&out, buf.c, ndims, start, count, layout, vname, dimnames, stride);
+		break;
+	case NC_SHORT:
+		print_values(&out, buf.s, ndims, start, count, layout, vname, dimnames, stride);
+		break;
+	case NC_INT:
+		print_values(&out, buf.i, ndims, start, count, layout, vname, dimnames, stride);
+		break;
+	case NC_FLOAT:
+		print_values(&out, buf.f, ndims, start, count, layout, vname, dimnames, stride);
+		break;
+	case NC_DOUBLE:
+		print_values(&out, buf.d, ndims, start, count, layout, vname, dimnames, stride);
+		break;
+	default:
+		printf("ABORT: variable type not implemented!\n");
+		exit(EXIT_FAILURE);
 	}
-	printf("]");
+	out.flush();
+
+	if (this->pool) this->pool->release(buf.v);
+	else free(buf.v);
 }
 
 /* print variable data */
-void WRFncdf::printvardata(string vname) {
+void WRFncdf::printvardata(string vname, PrintLayout layout) {
 	int ndims = this->varndims(vname);
 	if (ndims > 4) {
 		printf("ABORT: %iD data not supported!\n", ndims);
 		exit (EXIT_FAILURE);
 	}
 
-	// read data
-	size_t dimlens[this->varndims(vname)];
-	union buf buf;
-	int vtype;
-	buf.v = this->vardata(vname, &vtype, &ndims, dimlens);
+	// get slicing indices
+	size_t start[ndims];
+	size_t dimlens[ndims];
+	size_t *dims = this->vardims(vname);
+	for (int i = 0; i < ndims; i++) {
+		start[i] = 0;
+		dimlens[i] = this->dimlen(dims[i]);
+	}
 
-	print_data(&buf, dimlens, 1, ndims, 0, vtype);
-	printf("\n");
+	this->printslab(vname, start, dimlens, NULL, layout);
 }
 
-void WRFncdf::printvardata(int step, string vname) {
+void WRFncdf::printvardata(int step, string vname, PrintLayout layout) {
 	int ndims = this->varndims(vname);
 	if (ndims > 4) {
 		printf("ABORT: %iD data not supported!\n", ndims);
@@ -725,26 +812,20 @@ void WRFncdf::printvardata(int step, string vname) {
 	}
 
 	// get slicing indices
-	size_t start[this->varndims(vname)];
-	size_t dimlens[this->varndims(vname)];
+	size_t start[ndims];
+	size_t dimlens[ndims];
 	size_t *dims = this->vardims(vname);
-	start[0] = 0;
+	start[0] = step;
 	dimlens[0] = 1;
 	for (int i = 1; i < ndims; i++) {
 		start[i] = 0;
 		dimlens[i] = this->dimlen(dims[i]);
 	}
 
-	// read data
-	union buf buf;
-	int vtype;
-	buf.v = this->vardata(vname, &vtype, &ndims, start, dimlens);
-
-	print_data(&buf, dimlens, 1, ndims, 0, vtype);
-	printf("\n");
+	this->printslab(vname, start, dimlens, NULL, layout);
 }
 
-void WRFncdf::printvardata(int step, int level, string vname) {
+void WRFncdf::printvardata(int step, int level, string vname, PrintLayout layout) {
 	int ndims = this->varndims(vname);
 	if (ndims > 4) {
 		printf("ABORT: %iD data not supported!\n", ndims);
@@ -752,8 +833,8 @@ void WRFncdf::printvardata(int step, int level, string vname) {
 	}
 
 	// get slicing indices
-	size_t start[this->varndims(vname)];
-	size_t dimlens[this->varndims(vname)];
+	size_t start[ndims];
+	size_t dimlens[ndims];
 	size_t *dims = this->vardims(vname);
 	start[0] = step;
 	dimlens[0] = 1;
@@ -764,13 +845,193 @@ void WRFncdf::printvardata(int step, int level, string vname) {
 		dimlens[i] = this->dimlen(dims[i]);
 	}
 
+	this->printslab(vname, start, dimlens, NULL, layout);
+}
+
+/* returns NumPy type descriptor of netCDF type */
+static string npy_descr(int vtype) {
+	string bo = (ENDIAN_HOST == ENDIAN_BIG) ? ">" : "<";
+	switch (vtype) {
+	case NC_CHAR: return "|S1";
+	case NC_BYTE: return "|i1";
+	case NC_SHORT: return bo+"i2";
+	case NC_INT: return bo+"i4";
+	case NC_FLOAT: return bo+"f4";
+	case NC_DOUBLE: return bo+"f8";
+	default:
+		printf("ABORT: variable type not implemented!\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* writes (strided) slab of variable into binary file (values are written unformatted from read buffer)
+ * INPUT:
+ *  vname		variable name
+ *  start		slab start indices
+ *  count		slab lengths
+ *  stride		slab index strides (NULL: contiguous slab)
+ *  filename	output file ("-" writes to stdout, raw header then goes to stderr)
+ *  format		EXPORT_RAW: values in host byte order and text header in <filename>.hdr
+ *  			EXPORT_NPY: NumPy .npy (version 1.0) file
+ */
+void WRFncdf::exportslab(string vname, size_t *start, size_t *count, ptrdiff_t *stride, string filename, ExportFormat format) {
+	int ndims = this->varndims(vname);
+	int vtype = this->vartype(vname);
+	string descr = npy_descr(vtype);
+	size_t n = 1;
+	for (int i = 0; i < ndims; i++) n *= count[i];
+
 	// read data
-	union buf buf;
+	void *data = this->vardata(vname, &vtype, &ndims, start, count, stride);
+
+	// open output
+	bool std_out = (filename == "-");
+	FILE *out = std_out ? stdout : fopen(filename.c_str(), "wb");
+	if (!out) {
+		printf("ABORT: Can not open %s!\n", filename.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	if (format == EXPORT_NPY) {
+		// header dict padded with spaces to a multiple of 64 Bytes (including 10 Byte preamble)
+		string shape = "(";
+		for (int i = 0; i < ndims; i++) shape += to_string(count[i]) + ((ndims == 1 or i < ndims-1) ? ", " : "");
+		shape += ")";
+		string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+		dict.append(63 - (10+dict.size()) % 64, ' ');
+		dict += '\n';
+		unsigned short hlen = dict.size();
+		::byte pre[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+		encode<ENDIAN_LITTLE>(hlen, &pre[8]);
+		fwrite(pre, 1, 10, out);
+		fwrite(dict.data(), 1, dict.size(), out);
+	} else {
+		// text header describing shape, type and dimensions of raw file
+		FILE *hdr = std_out ? stderr : fopen((filename+".hdr").c_str(), "w");
+		if (!hdr) {
+			printf("ABORT: Can not open %s.hdr!\n", filename.c_str());
+			exit(EXIT_FAILURE);
+		}
+		fprintf(hdr, "variable = %s\n", vname.c_str());
+		fprintf(hdr, "type = %s\n", this->vartypename(vname).c_str());
+		fprintf(hdr, "dtype = %s\n", descr.c_str());
+		fprintf(hdr, "byteorder = %s\n", (ENDIAN_HOST == ENDIAN_BIG) ? "big" : "little");
+		fprintf(hdr, "ndims = %i\n", ndims);
+		for (int i = 0; i < ndims; i++) {
+			fprintf(hdr, "dim%i = %s %zu %zu %zi\n", i, this->vardimname(vname, i).c_str(), start[i], count[i], stride ? stride[i] : 1);
+		}
+		fprintf(hdr, "order = C\n");
+		if (!std_out) fclose(hdr);
+	}
+
+	if (n > 0 and fwrite(data, this->vartypesize(vname), n, out) != n) {
+		printf("ABORT: Error writing %s!\n", filename.c_str());
+		exit(EXIT_FAILURE);
+	}
+	if (std_out) fflush(out);
+	else fclose(out);
+
+	if (this->pool) this->pool->release(data);
+	else free(data);
+}
+
+/* export variable data into binary file */
+void WRFncdf::exportvardata(string vname, string filename, ExportFormat format) {
+	int ndims = this->varndims(vname);
+
+	// get slicing indices
+	size_t start[ndims];
+	size_t dimlens[ndims];
+	size_t *dims = this->vardims(vname);
+	for (int i = 0; i < ndims; i++) {
+		start[i] = 0;
+		dimlens[i] = this->dimlen(dims[i]);
+	}
+
+	this->exportslab(vname, start, dimlens, NULL, filename, format);
+}
+
+void WRFncdf::exportvardata(int step, string vname, string filename, ExportFormat format) {
+	int ndims = this->varndims(vname);
+	if (ndims < 1) {
+		printf("ABORT: Time slicing of %iD data not supported!\n", ndims);
+		exit (EXIT_FAILURE);
+	}
+
+	// get slicing indices
+	size_t start[ndims];
+	size_t dimlens[ndims];
+	size_t *dims = this->vardims(vname);
+	start[0] = step;
+	dimlens[0] = 1;
+	for (int i = 1; i < ndims; i++) {
+		start[i] = 0;
+		dimlens[i] = this->dimlen(dims[i]);
+	}
+
+	this->exportslab(vname, start, dimlens, NULL, filename, format);
+}
+
+void WRFncdf::exportvardata(int step, int level, string vname, string filename, ExportFormat format) {
+	int ndims = this->varndims(vname);
+	if (ndims < 2) {
+		printf("ABORT: Level slicing of %iD data not supported!\n", ndims);
+		exit (EXIT_FAILURE);
+	}
+
+	// get slicing indices
+	size_t start[ndims];
+	size_t dimlens[ndims];
+	size_t *dims = this->vardims(vname);
+	start[0] = step;
+	dimlens[0] = 1;
+	start[1] = level;
+	dimlens[1] = 1;
+	for (int i = 2; i < ndims; i++) {
+		start[i] = 0;
+		dimlens[i] = this->dimlen(dims[i]);
+	}
+
+	this->exportslab(vname, start, dimlens, NULL, filename, format);
+}
+
+/* plots (strided) slab of variable (slab has to have exactly two dimensions with more than one element) */
+void WRFncdf::plotslab(string vname, size_t *start, size_t *count, ptrdiff_t *stride) {
+	int ndims = this->varndims(vname);
 	int vtype;
-	buf.v = this->vardata(vname, &vtype, &ndims, start, dimlens);
+	size_t n[2];
+	int nplot = 0;
+	for (int i = 0; i < ndims; i++) {
+		if (count[i] == 1) continue;
+		if (nplot == 2) {
+			printf("ABORT: Slab has more than two dimensions, select single time/level for plotting!\n");
+			exit (EXIT_FAILURE);
+		}
+		n[nplot++] = count[i];
+	}
+	if (nplot != 2) {
+		printf("ABORT: Slab has less than two dimensions, can not be plotted!\n");
+		exit (EXIT_FAILURE);
+	}
+	if (this->vartype(vname) != NC_FLOAT) {
+		printf("ABORT: Only float variables can be plotted!\n");
+		exit (EXIT_FAILURE);
+	}
+
+	// read data
+	void *data = this->vardata(vname, &vtype, &ndims, start, count, stride);
 
-	print_data(&buf, dimlens, 1, ndims, 0, vtype);
-	printf("\n");
+    //plot data
+#ifdef QUICKPLOT_H_
+	float zmin, zmax;
+	vec_minmax(n[0]*n[1], (float *)data, &zmin, &zmax, true);
+	QuickPlot_xy(n[1], n[0], (float *)data, zmin, zmax);
+#else
+	cout << "Plot option was not compiled!\n";
+#endif
+
+	if (this->pool) this->pool->release(data);
+	else free(data);
 }
 
 /* plots variable data */
@@ -808,7 +1069,7 @@ void WRFncdf::plotvardata(int step, string vname) {
 	size_t start[this->varndims(vname)];
 	size_t dimlens[this->varndims(vname)];
 	size_t *dims = this->vardims(vname);
-	start[0] = 0;
+	start[0] = step;
 	dimlens[0] = 1;
 	for (int i = 1; i < ndims; i++) {
 		start[i] = 0;
@@ -1006,26 +1267,32 @@ void WRFncdf::putvaratt(int varid, string aname, int atype, size_t len, union WR
 /* put global attribute */
 void WRFncdf::putgatt(string aname, size_t len, string aval) {
 	this->putvaratt(NC_GLOBAL, aname, len, aval);
+	this->gattread.assign(this->gattread.size(), false);
 }
 
 void WRFncdf::putgatt(string aname, size_t len, int aval) {
 	this->putvaratt(NC_GLOBAL, aname, len, aval);
+	this->gattread.assign(this->gattread.size(), false);
 }
 
 void WRFncdf::putgatt(string aname, size_t len, long aval) {
 	this->putvaratt(NC_GLOBAL, aname, len, aval);
+	this->gattread.assign(this->gattread.size(), false);
 }
 
 void WRFncdf::putgatt(string aname, size_t len, float aval) {
 	this->putvaratt(NC_GLOBAL, aname, len, aval);
+	this->gattread.assign(this->gattread.size(), false);
 }
 
 void WRFncdf::putgatt(string aname, size_t len, double aval) {
 	this->putvaratt(NC_GLOBAL, aname, len, aval);
+	this->gattread.assign(this->gattread.size(), false);
 }
 
 void WRFncdf::putgatt(string aname, int atype, size_t len, union WRFattval aval) {
 	this->putvaratt(NC_GLOBAL, aname, atype, len, aval);
+	this->gattread.assign(this->gattread.size(), false);
 }
 
 void WRFncdf::putdata(int varid, size_t *start, size_t *stop, void *data, int vtype) {
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <netcdf.h>
+#include "libutils.h"
 /* Full documentation of the netCDF C++ API can be found at:
  * http://www.unidata.ucar.edu/software/netcdf/docs/netcdf-cxx
  */
@@ -27,6 +28,12 @@ union WRFattval {
 	long long ll;
 };
 
+/* binary export formats of variable data */
+enum ExportFormat {
+	EXPORT_RAW, // plain values in host byte order plus text header <file>.hdr
+	EXPORT_NPY  // NumPy .npy file (header and values in one file)
+};
+
 class WRFncdf {
 	string filename;
 	int stat, igrp, dims, nunlims, inkind, vars;
@@ -38,8 +45,14 @@ class WRFncdf {
 	vector <string> dimnames;
 	vector <string> varnames;
 	vector <string> gattnames;
+	vector <WRFattval> gattvals; // global attribute values (read once on first request)
+	vector <bool> gattread;
+	vector < vector<size_t> > vardimids; // cached dimension ids of variables
+	BufferPool *pool; // pool for data buffers (NULL: malloc)
 
 	void Init (string, int); //Initialize WRF object
+	void *allocdata(size_t); // allocates data buffer
+	void readslab(int, int, size_t*, size_t*, ptrdiff_t*, void*); // reads (strided) variable slab into buffer
 
   public:
 	/* constructor and destructor */
@@ -59,6 +72,7 @@ class WRFncdf {
    int ndims(void); // returns number of dims
    int dimid(string); // returns dim id of dim name
    size_t dimlen(int); // returns dim length of dim id
+   size_t syncdimlen(int); // re-reads dim length of dim id from file (e.g. unlimited dim of file being written)
    string dimname(int); // returns dim name of dim id
    bool is_unlim(int);
 
@@ -81,15 +95,25 @@ class WRFncdf {
    string vardimname(string, string);
    size_t varcount(string); // returns count of variable elements
    void* vardata(string, int*, int*, size_t*, size_t*); // returns variable data
+   void* vardata(string, int*, int*, size_t*, size_t*, ptrdiff_t*); // returns strided variable data
    void* vardata(string, int*, int*, size_t*); // returns variable data
    void* vardataraw(string);
    void* vardata(string);
+   void vardata(string, size_t*, size_t*, void*); // reads variable slab into given buffer
+   void vardata(string, size_t*, size_t*, ptrdiff_t*, void*); // reads strided variable slab into given buffer
+   void setpool(BufferPool*); // takes data buffers returned by vardata methods from pool
    void plotvardata(string); // plot variable data
    void plotvardata(int, string);
    void plotvardata(int, int, string);
-   void printvardata(string); // print variable data
-   void printvardata(int, string);
-   void printvardata(int, int, string);
+   void printvardata(string, PrintLayout layout = PRINT_NESTED); // print variable data
+   void printvardata(int, string, PrintLayout layout = PRINT_NESTED);
+   void printvardata(int, int, string, PrintLayout layout = PRINT_NESTED);
+   void exportvardata(string, string, ExportFormat); // export variable data into binary file
+   void exportvardata(int, string, string, ExportFormat);
+   void exportvardata(int, int, string, string, ExportFormat);
+   void printslab(string, size_t*, size_t*, ptrdiff_t*, PrintLayout); // print/plot/export (strided) variable slab
+   void plotslab(string, size_t*, size_t*, ptrdiff_t*);
+   void exportslab(string, size_t*, size_t*, ptrdiff_t*, string, ExportFormat);
 
    /* attribute methods */
    int natts(int); // returns number of attributes